@@ -0,0 +1,52 @@
+"""
+Read a ClusterHead arrival trace (ArrivalTrace.h, recordArrivals = true)
+
+Usage:  python3 arrival_trace.py results/Record-0-arrivals.bin > arrivals.csv
+
+As a module: read_arrivals(path) yields one dict per sample in arrival order.
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct('<4sIIi')
+# arrivalTime, senseTime (raw ticks), T, H, L, V, sourceId, requestId, seqNo, isOutlier
+RECORD = struct.Struct('<qq4d3iB3x')
+
+FIELDS = ['ArrivalTime', 'SenseTime', 'Temperature', 'Humidity', 'Light', 'Voltage',
+          'SourceId', 'RequestId', 'SeqNo', 'IsOutlier']
+
+def read_arrivals(path):
+    """Yield {field: value} per record, times in seconds; stops at a truncated record"""
+    with open(path, 'rb') as f:
+        magic, version, record_size, scale_exp = HEADER.unpack(f.read(HEADER.size))
+        if magic != b'ODAT' or version != 1 or record_size != RECORD.size:
+            raise ValueError(f"{path}: not an arrival trace (magic={magic}, version={version}, "
+                             f"record size={record_size})")
+        scale = 10.0 ** scale_exp
+        while True:
+            data = f.read(record_size)
+            if len(data) < record_size:
+                return
+            values = list(RECORD.unpack(data))
+            values[0] *= scale
+            values[1] *= scale
+            yield dict(zip(FIELDS, values))
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert an ODA-MD arrival trace to CSV')
+    parser.add_argument('trace')
+    args = parser.parse_args()
+
+    print(','.join(FIELDS))
+    count = 0
+    for r in read_arrivals(args.trace):
+        print(f"{r['ArrivalTime']:.6f},{r['SenseTime']:.6f},{r['Temperature']:.6g},{r['Humidity']:.6g},"
+              f"{r['Light']:.6g},{r['Voltage']:.6g},{r['SourceId']},{r['RequestId']},{r['SeqNo']},"
+              f"{r['IsOutlier']}")
+        count += 1
+    print(f"# {count} arrivals", file=sys.stderr)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+"""
+Build a baseline model for warm-started detection (ClusterHead baselineModel)
+
+Mean and covariance of clean Intel Lab readings from a date range before the
+simulated one (the simulation replays 2004-03-11 .. 2004-03-14), so the
+baseline never sees the evaluated samples. Gross sensor errors in the raw
+data are trimmed: fit, drop readings with MD^2 above the chi-square(4)
+0.999 quantile, refit, until nothing changes.
+
+Usage:  python3 baseline_model.py ../data.txt -o baseline.txt
+        python3 baseline_model.py ../data.txt --motes "" --start 2004-03-01 --end 2004-03-10
+
+Output format: see src/BaselineModel.h.
+"""
+
+import argparse
+import sys
+
+DIM = 4
+CHI2_4_999 = 18.467     # MD^2 cutoff for trimming
+
+def read_readings(path, motes, start, end):
+    """(T, H, L, V) of the lines matching the motes and date range, like IntelLabData::loadData"""
+    rows = []
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) < 8:
+                continue
+            try:
+                mote = int(fields[3])
+                x = [float(v) for v in fields[4:8]]
+            except ValueError:
+                continue
+            if motes and mote not in motes:
+                continue
+            if start <= fields[0] <= end:
+                rows.append(x)
+    return rows
+
+def fit(rows):
+    n = len(rows)
+    mean = [sum(r[j] for r in rows) / n for j in range(DIM)]
+    cov = [[sum((r[j] - mean[j]) * (r[k] - mean[k]) for r in rows) / (n - 1)
+            for k in range(DIM)] for j in range(DIM)]
+    return mean, cov
+
+def invert(m):
+    """Gauss-Jordan with partial pivoting; None if singular"""
+    a = [row[:] + [1.0 if i == j else 0.0 for j in range(DIM)] for i, row in enumerate(m)]
+    for c in range(DIM):
+        p = max(range(c, DIM), key=lambda r: abs(a[r][c]))
+        if abs(a[p][c]) < 1e-12:
+            return None
+        a[c], a[p] = a[p], a[c]
+        pivot = a[c][c]
+        a[c] = [v / pivot for v in a[c]]
+        for r in range(DIM):
+            if r != c:
+                f = a[r][c]
+                a[r] = [v - f * w for v, w in zip(a[r], a[c])]
+    return [row[DIM:] for row in a]
+
+def md2(x, mean, inv):
+    d = [x[j] - mean[j] for j in range(DIM)]
+    return sum(d[j] * inv[j][k] * d[k] for j in range(DIM) for k in range(DIM))
+
+def trimmed_fit(rows, max_rounds):
+    """Fit, drop readings beyond the chi-square cutoff, repeat"""
+    for _ in range(max_rounds):
+        mean, cov = fit(rows)
+        # Same diagonal as the detector, so constant features stay invertible
+        inv = invert([[cov[j][k] + (0.001 if j == k else 0.0) for k in range(DIM)] for j in range(DIM)])
+        if inv is None:
+            raise ValueError("covariance is singular")
+        kept = [r for r in rows if md2(r, mean, inv) <= CHI2_4_999]
+        if len(kept) == len(rows) or len(kept) <= DIM:
+            break
+        rows = kept
+    return rows, fit(rows)
+
+def main():
+    parser = argparse.ArgumentParser(description='Build an ODA-MD baseline model from Intel Lab data')
+    parser.add_argument('data', help='Intel Lab data.txt')
+    parser.add_argument('-o', '--output', default='baseline.txt')
+    parser.add_argument('--motes', default='36 37 38', help='mote IDs ("" = all motes)')
+    parser.add_argument('--start', default='2004-03-06', help='first date (inclusive)')
+    parser.add_argument('--end', default='2004-03-10', help='last date (inclusive)')
+    parser.add_argument('--trim-rounds', type=int, default=10, help='trimming refits (0 = no trimming)')
+    args = parser.parse_args()
+
+    motes = {int(m) for m in args.motes.split()}
+    rows = read_readings(args.data, motes, args.start, args.end)
+    if len(rows) <= DIM:
+        sys.exit(f"{args.data}: only {len(rows)} readings between {args.start} and {args.end}")
+    total = len(rows)
+    if args.trim_rounds > 0:
+        rows, (mean, cov) = trimmed_fit(rows, args.trim_rounds)
+    else:
+        mean, cov = fit(rows)
+
+    with open(args.output, 'w') as f:
+        f.write(f"# ODA-MD baseline: motes {args.motes or 'all'}, {args.start} .. {args.end}, "
+                f"{len(rows)} of {total} readings kept\n")
+        f.write("version 1\n")
+        f.write(f"count {len(rows)}\n")
+        f.write("mean " + " ".join(f"{v:.10g}" for v in mean) + "\n")
+        f.write("cov " + " ".join(f"{v:.10g}" for row in cov for v in row) + "\n")
+    print(f"{args.output}: {len(rows)} of {total} readings, mean T={mean[0]:.2f} H={mean[1]:.2f} "
+          f"L={mean[2]:.1f} V={mean[3]:.3f}", file=sys.stderr)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+"""
+Scalability benchmark for the ODA-MD simulation
+Runs every iteration of the [Config Scalability] section (N clusters x M sensors),
+measures wall-clock time, events/sec and peak RSS per run, and collects the
+per-module event counts recorded as 'eventsHandled' scalars.
+
+Usage:  python3 benchmark.py [--config Scalability] [--runs 0,1,2] [--compare]
+Output: benchmarks/<config>.csv and benchmarks/<config>.png
+
+--compare checks the new results against the committed benchmarks/<config>.csv
+before replacing it, and exits with status 1 on a regression: a changed event
+count (the model did different work) or events/sec below the baseline by more
+than --tolerance.
+"""
+
+import argparse
+import csv
+import os
+import re
+import subprocess
+import sys
+import time
+
+# Get script directory (simulations/, where omnetpp.ini lives)
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+SIM_BINARY = os.path.join(SCRIPT_DIR, '..', 'src', 'oda_md')
+NED_PATH = '.:../src'
+OUT_DIR = os.path.join(SCRIPT_DIR, 'benchmarks')
+
+def sim_command(config, extra=None):
+    """Cmdenv command line for a config of omnetpp.ini"""
+    cmd = [SIM_BINARY, '-n', NED_PATH, '-u', 'Cmdenv', '-c', config]
+    return cmd + (extra or [])
+
+def count_runs(config):
+    """Number of runs (iterations) in a config"""
+    out = subprocess.run(sim_command(config, ['-q', 'numruns']),
+                         cwd=SCRIPT_DIR, capture_output=True, text=True, check=True)
+    match = re.search(r'(\d+)\s*$', out.stdout.strip())
+    return int(match.group(1)) if match else 0
+
+def run_once(config, run):
+    """Run one simulation; return (wall seconds, events, peak RSS in MB, stdout)"""
+    start = time.perf_counter()
+    proc = subprocess.Popen(sim_command(config, ['-r', str(run)]), cwd=SCRIPT_DIR,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    stdout = proc.stdout.read()
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        raise RuntimeError(f"run {run} failed:\n{stdout[-2000:]}")
+
+    # "<!> Simulation time limit reached -- at t=600s, event #123456"
+    events = 0
+    for match in re.finditer(r'event #(\d+)', stdout):
+        events = int(match.group(1))
+    peak_rss_mb = rusage.ru_maxrss / 1024.0  # Linux reports KiB
+    return wall, events, peak_rss_mb, stdout
+
+def read_scalars(sca_file):
+    """Parse itervars and per-module eventsHandled from an .sca file"""
+    itervars = {}
+    events_by_type = {}
+    with open(sca_file) as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) >= 3 and parts[0] == 'itervar':
+                itervars[parts[1]] = parts[2].strip('"')
+            elif len(parts) >= 4 and parts[0] == 'scalar' and parts[2] == 'eventsHandled':
+                # Module type = last path component without vector index
+                module = re.sub(r'\[\d+\]', '', parts[1].split('.')[-1])
+                events_by_type[module] = events_by_type.get(module, 0) + float(parts[3])
+    return itervars, events_by_type
+
+def plot(rows, output_file):
+    """Wall time, events/sec and peak RSS against network size"""
+    import matplotlib.pyplot as plt  # Only needed for the plot, not by parsim_benchmark.py
+
+    nodes = [r['nodes'] for r in rows]
+    fig, axes = plt.subplots(1, 3, figsize=(15, 4.5))
+
+    axes[0].plot(nodes, [r['wall_s'] for r in rows], 'b-o')
+    axes[0].set_ylabel('Wall-clock time (s)')
+    axes[1].plot(nodes, [r['events_per_s'] for r in rows], 'g-o')
+    axes[1].set_ylabel('Events / s')
+    axes[2].plot(nodes, [r['peak_rss_mb'] for r in rows], 'r-o')
+    axes[2].set_ylabel('Peak RSS (MB)')
+
+    for ax in axes:
+        ax.set_xscale('log')
+        ax.set_xlabel('Nodes (CHs + sensors)')
+        ax.grid(True, alpha=0.3)
+
+    plt.tight_layout()
+    plt.savefig(output_file, dpi=150, bbox_inches='tight')
+    print(f"Saved: {output_file}")
+    plt.close()
+
+def compare(rows, baseline_file, tolerance):
+    """Regressions of rows against a committed CSV, as messages"""
+    if not os.path.exists(baseline_file):
+        raise SystemExit(f"--compare: no baseline {baseline_file}; run without --compare and commit it")
+    with open(baseline_file, newline='') as f:
+        baseline = {int(r['clusters']): r for r in csv.DictReader(f)}
+
+    problems = []
+    for row in rows:
+        base = baseline.get(row['clusters'])
+        if base is None:
+            print(f"N={row['clusters']}: not in the baseline, skipped")
+            continue
+        for key in ('events', 'events_clusterHead', 'events_sensor', 'events_sink'):
+            if row[key] != int(base[key]):
+                problems.append(f"N={row['clusters']}: {key} {base[key]} -> {row[key]}")
+        floor = float(base['events_per_s']) * (1.0 - tolerance)
+        if row['events_per_s'] < floor:
+            problems.append(f"N={row['clusters']}: events/s {base['events_per_s']} -> {row['events_per_s']}"
+                            f" (more than {tolerance:.0%} slower)")
+    return problems
+
+def main():
+    parser = argparse.ArgumentParser(description='ODA-MD scalability benchmark')
+    parser.add_argument('--config', default='Scalability')
+    parser.add_argument('--runs', default=None, help='comma-separated run numbers (default: all)')
+    parser.add_argument('--sensors-per-cluster', type=int, default=15)
+    parser.add_argument('--compare', action='store_true', help='fail on a regression against the committed CSV')
+    parser.add_argument('--tolerance', type=float, default=0.2, help='allowed events/sec drop for --compare')
+    args = parser.parse_args()
+
+    runs = ([int(r) for r in args.runs.split(',')] if args.runs
+            else list(range(count_runs(args.config))))
+    os.makedirs(OUT_DIR, exist_ok=True)
+
+    rows = []
+    for run in runs:
+        wall, events, rss, _ = run_once(args.config, run)
+        sca = os.path.join(SCRIPT_DIR, 'results', f'{args.config}-{run}.sca')
+        itervars, events_by_type = read_scalars(sca)
+
+        clusters = int(itervars.get('N', 0))
+        sensors = clusters * args.sensors_per_cluster
+        row = {
+            'run': run,
+            'clusters': clusters,
+            'nodes': clusters + sensors,
+            'wall_s': round(wall, 3),
+            'events': events,
+            'events_per_s': round(events / wall, 1) if wall > 0 else 0,
+            'peak_rss_mb': round(rss, 1),
+            'events_clusterHead': int(events_by_type.get('clusterHead', 0)),
+            'events_sensor': int(events_by_type.get('sensor', 0)),
+            'events_sink': int(events_by_type.get('sink', 0)),
+        }
+        rows.append(row)
+        print(f"N={clusters:5d} nodes={row['nodes']:6d} wall={wall:8.2f}s "
+              f"ev/s={row['events_per_s']:12.1f} rss={rss:8.1f}MB")
+
+    rows.sort(key=lambda r: r['nodes'])
+    csv_file = os.path.join(OUT_DIR, f'{args.config}.csv')
+    problems = compare(rows, csv_file, args.tolerance) if args.compare else []
+    with open(csv_file, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f"Saved: {csv_file}")
+
+    plot(rows, os.path.join(OUT_DIR, f'{args.config}.png'))
+
+    if problems:
+        print("Regressions against the baseline:", file=sys.stderr)
+        for p in problems:
+            print("  " + p, file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
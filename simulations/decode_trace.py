@@ -0,0 +1,45 @@
+"""
+Decode a ClusterHead binary decision trace (TraceRing.h) into text or CSV
+
+Usage:  python3 decode_trace.py results/ODAMD-0-trace.bin
+        python3 decode_trace.py results/ODAMD-0-trace.bin --csv > trace.csv
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct('<4sIII QQ')
+RECORD = struct.Struct('<d i f B B H')   # time, sourceId, score, blocked, truth, reserved
+
+LABELS = {(1, 1): 'TP', (1, 0): 'FN-MISSED!', (0, 1): 'FP', (0, 0): 'TN'}
+
+def read_trace(filename):
+    """Yield (time, sourceId, score, blocked, truth) tuples, oldest first"""
+    with open(filename, 'rb') as f:
+        magic, version, record_size, _, total, count = HEADER.unpack(f.read(HEADER.size))
+        if magic != b'ODTR' or version != 1:
+            raise ValueError(f"{filename}: not an ODA-MD trace (magic={magic}, version={version})")
+        print(f"# {count} of {total} decisions", file=sys.stderr)
+        for _ in range(count):
+            data = f.read(record_size)
+            time, source, score, blocked, truth, _ = RECORD.unpack(data[:RECORD.size])
+            yield time, source, score, blocked, truth
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode an ODA-MD decision trace')
+    parser.add_argument('trace')
+    parser.add_argument('--csv', action='store_true', help='CSV instead of log-style text')
+    args = parser.parse_args()
+
+    if args.csv:
+        print("Time,SourceId,Score,Blocked,Truth")
+    for time, source, score, blocked, truth in read_trace(args.trace):
+        if args.csv:
+            print(f"{time:.6f},{source},{score:.6g},{blocked},{truth}")
+        else:
+            action = 'BLOCKED' if blocked else 'FORWARDED'
+            print(f"[{time:.3f}] Node{source} MD={score:.4f} [{LABELS[(truth, blocked)]}] -> {action}")
+
+if __name__ == "__main__":
+    main()
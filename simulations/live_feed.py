@@ -0,0 +1,143 @@
+"""
+Live feed for the Live config (LiveGateway over a UNIX domain socket)
+
+Stand-in for a gateway: replays a recorded arrival trace (Record config,
+ClusterHead.recordArrivals) into a running simulation, one reading per line,
+at the recorded pace (scaled by --speed), and collects the decisions that
+stream back. Prints the ingest -> decision latency percentiles measured by
+the simulation, the client round trip and DA/FAR of the decisions.
+
+Usage:  ./run -c Live -u Cmdenv &      (from simulations/)
+        python3 live_feed.py results/arrivals.bin --speed 10 -o decisions.csv
+
+Protocol: see src/LiveGateway.cc.
+"""
+
+import argparse
+import socket
+import sys
+import threading
+import time
+
+from arrival_trace import read_arrivals
+
+def connect(path, timeout):
+    """Connect to the simulation's socket, retrying until it is listening"""
+    deadline = time.monotonic() + timeout
+    while True:
+        s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            s.connect(path)
+            return s
+        except OSError:
+            s.close()
+            if time.monotonic() >= deadline:
+                raise
+            time.sleep(0.2)
+
+def percentile(values, q):
+    """Nearest-rank percentile of a sorted list"""
+    if not values:
+        return float('nan')
+    return values[min(len(values) - 1, int(q * len(values)))]
+
+class DecisionReader(threading.Thread):
+    """Reads decision lines until the simulation closes the socket"""
+
+    def __init__(self, sock, sent):
+        super().__init__(daemon=True)
+        self.sock = sock
+        self.sent = sent            # (source, seqNo) -> (send time, isOutlier)
+        self.decisions = []
+
+    def run(self):
+        buffer = b''
+        while True:
+            try:
+                data = self.sock.recv(65536)
+            except OSError:
+                return
+            if not data:
+                return
+            now = time.monotonic()
+            buffer += data
+            *lines, buffer = buffer.split(b'\n')
+            for line in lines:
+                fields = line.split()
+                if len(fields) != 6:
+                    continue
+                source, seq = int(fields[0]), int(fields[1])
+                sent_at, label = self.sent.get((source, seq), (None, 0))
+                self.decisions.append({
+                    'SourceId': source, 'SeqNo': seq, 'Score': float(fields[2]),
+                    'Detected': int(fields[3]), 'IsOutlier': label,
+                    'LatencyUs': int(fields[4]), 'Late': int(fields[5]),
+                    'RoundTripUs': int((now - sent_at) * 1e6) if sent_at is not None else -1})
+
+def main():
+    parser = argparse.ArgumentParser(description='Replay an arrival trace into a live ODA-MD simulation')
+    parser.add_argument('trace', nargs='?', default='results/arrivals.bin', help='arrival trace (Record config)')
+    parser.add_argument('--socket', default='odamd-live.sock', help='live-socket-path of the simulation')
+    parser.add_argument('--speed', type=float, default=1.0, help='replay speed-up (0 = as fast as possible)')
+    parser.add_argument('--limit', type=int, default=0, help='stop after this many readings (0 = all)')
+    parser.add_argument('--drain', type=float, default=2.0, help='seconds to wait for decisions after the last reading')
+    parser.add_argument('--connect-timeout', type=float, default=30.0)
+    parser.add_argument('-o', '--output', help='decisions CSV')
+    args = parser.parse_args()
+
+    sock = connect(args.socket, args.connect_timeout)
+    sent = {}
+    reader = DecisionReader(sock, sent)
+    reader.start()
+
+    next_seq = {}
+    start = time.monotonic()
+    first_arrival = None
+    count = 0
+    for r in read_arrivals(args.trace):
+        if args.limit and count >= args.limit:
+            break
+        if first_arrival is None:
+            first_arrival = r['ArrivalTime']
+        if args.speed > 0:
+            delay = start + (r['ArrivalTime'] - first_arrival) / args.speed - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+        source = r['SourceId']
+        seq = next_seq.get(source, 0)     # Same numbering as LiveGateway
+        next_seq[source] = seq + 1
+        sent[(source, seq)] = (time.monotonic(), r['IsOutlier'])
+        sock.sendall(f"{source} {r['Temperature']:.6g} {r['Humidity']:.6g} {r['Light']:.6g} "
+                     f"{r['Voltage']:.6g} {r['IsOutlier']}\n".encode())
+        count += 1
+
+    time.sleep(args.drain)
+    sock.shutdown(socket.SHUT_WR)       # Ends the run (stopOnDisconnect)
+    reader.join(args.drain)
+    sock.close()
+    decisions = list(reader.decisions)
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            fields = ['SourceId', 'SeqNo', 'Score', 'Detected', 'IsOutlier', 'LatencyUs', 'Late', 'RoundTripUs']
+            f.write(','.join(fields) + '\n')
+            for d in decisions:
+                f.write(','.join(str(d[k]) for k in fields) + '\n')
+
+    latency = sorted(d['LatencyUs'] for d in decisions if d['LatencyUs'] >= 0)
+    round_trip = sorted(d['RoundTripUs'] for d in decisions if d['RoundTripUs'] >= 0)
+    late = sum(d['Late'] for d in decisions)
+    outliers = [d for d in decisions if d['IsOutlier']]
+    normals = [d for d in decisions if not d['IsOutlier']]
+    print(f"{count} readings sent, {len(decisions)} decisions, {late} over the latency budget", file=sys.stderr)
+    for name, values in (('ingest->decision', latency), ('round trip', round_trip)):
+        print(f"{name:>17}: p50 {percentile(values, 0.50):.0f} us  p95 {percentile(values, 0.95):.0f} us  "
+              f"p99 {percentile(values, 0.99):.0f} us  max {values[-1] if values else float('nan'):.0f} us",
+              file=sys.stderr)
+    if outliers:
+        print(f"DA {100.0 * sum(d['Detected'] for d in outliers) / len(outliers):.2f}%", file=sys.stderr)
+    if normals:
+        print(f"FAR {100.0 * sum(d['Detected'] for d in normals) / len(normals):.2f}%", file=sys.stderr)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,84 @@
+"""
+Read a ClusterHead metrics time series (MetricsWriter.h), CSV or columnar
+
+Usage:  python3 metrics_reader.py results/ODAMD-0-metrics_odamd.odm > metrics.csv
+In code: read_metrics(path) -> {column: list}, iter_rows(path) -> dict per row
+"""
+
+import argparse
+import array
+import csv
+import struct
+import sys
+
+HEADER = struct.Struct('<4sII')     # magic, version, schema length
+TYPECODES = {'f8': 'd', 'i4': 'i', 'f4': 'f'}
+
+def _read_columnar(f, filename):
+    magic, version, schema_len = HEADER.unpack(f.read(HEADER.size))
+    if magic != b'ODMC' or version != 1:
+        raise ValueError(f"{filename}: not an ODA-MD metrics file (magic={magic}, version={version})")
+    schema = [field.split(':') for field in f.read(schema_len).decode().split(',')]
+    columns = {name: array.array(TYPECODES[kind]) for name, kind in schema}
+
+    while True:
+        data = f.read(4)
+        if len(data) < 4:
+            break
+        rows, = struct.unpack('<I', data)
+        chunk = []
+        for name, _ in schema:
+            col = array.array(columns[name].typecode)
+            raw = f.read(rows * col.itemsize)
+            if len(raw) < rows * col.itemsize:
+                chunk = None        # Incomplete last chunk (run aborted mid-write)
+                break
+            col.frombytes(raw)
+            chunk.append(col)
+        if chunk is None:
+            print(f"# {filename}: truncated chunk ignored", file=sys.stderr)
+            break
+        for (name, _), col in zip(schema, chunk):
+            columns[name].extend(col)
+    return {name: list(values) for name, values in columns.items()}
+
+def _read_csv(f):
+    reader = csv.DictReader(f)
+    columns = {name: [] for name in reader.fieldnames or []}
+    for row in reader:
+        for name in columns:
+            value = row[name]
+            columns[name].append(float(value) if '.' in value else int(value))
+    return columns
+
+def read_metrics(filename):
+    """Columns of a .csv or columnar (.odm) metrics file as {name: list}"""
+    with open(filename, 'rb') as f:
+        magic = f.read(4)
+    if magic == b'ODMC':
+        with open(filename, 'rb') as f:
+            return _read_columnar(f, filename)
+    with open(filename, newline='') as f:
+        return _read_csv(f)
+
+def iter_rows(filename):
+    """Rows of a metrics file as dicts, oldest first"""
+    columns = read_metrics(filename)
+    names = list(columns)
+    for values in zip(*(columns[name] for name in names)):
+        yield dict(zip(names, values))
+
+def main():
+    parser = argparse.ArgumentParser(description='Print an ODA-MD metrics file as CSV')
+    parser.add_argument('metrics')
+    args = parser.parse_args()
+
+    writer = None
+    for row in iter_rows(args.metrics):
+        if writer is None:
+            writer = csv.DictWriter(sys.stdout, fieldnames=list(row))
+            writer.writeheader()
+        writer.writerow(row)
+
+if __name__ == "__main__":
+    main()
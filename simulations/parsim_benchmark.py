@@ -0,0 +1,131 @@
+"""
+Parallel simulation benchmark for the multi-cluster ODA-MD network
+Runs [Config ParSimSequential] and [Config ParSim] for each cluster count,
+one partition (LP) per cluster plus one for the Sink, using named pipes on
+the local machine. Reports the speedup and checks that every per-cluster
+metrics CSV is identical between the sequential and the parallel run.
+
+Usage:  python3 parsim_benchmark.py
+        python3 parsim_benchmark.py --gen-ini 64   # regenerate parsim_clusters.ini
+Output: benchmarks/parsim.csv
+"""
+
+import argparse
+import csv
+import filecmp
+import glob
+import os
+import shutil
+import subprocess
+import time
+
+from benchmark import SCRIPT_DIR, OUT_DIR, sim_command
+
+# Must match ${N=...} in [Config ParSimSequential] (run number = list position)
+N_VALUES = [8, 16, 64]
+PARTITION_INI = os.path.join(SCRIPT_DIR, 'parsim_clusters.ini')
+
+def generate_partition_ini(max_clusters):
+    """One LP and one explicitly seeded RNG per cluster (identical seq/par streams)"""
+    with open(PARTITION_INI, 'w') as f:
+        f.write("# Generated by parsim_benchmark.py --gen-ini %d - do not edit\n" % max_clusters)
+        f.write("# Partition 0 = Sink, partition i+1 = cluster[i] (CH + its sensors).\n")
+        f.write("# Each cluster draws from its own RNG with a fixed seed, so sequential\n")
+        f.write("# and parallel runs see the same random streams.\n")
+        f.write("num-rngs = %d\n" % (max_clusters + 1))
+        f.write("*.sink.partition-id = 0\n")
+        for k in range(max_clusters + 1):
+            f.write("seed-%d-mt = %d\n" % (k, k + 1))
+        for i in range(max_clusters):
+            f.write("*.cluster[%d].partition-id = %d\n" % (i, i + 1))
+            f.write("*.cluster[%d].**.rng-0 = %d\n" % (i, i + 1))
+    print(f"Saved: {PARTITION_INI}")
+
+def collect_metrics(config, run, dest):
+    """Move the per-cluster metrics files (.csv or .odm) of one run into dest
+    (without the run prefix); an error if the run wrote none"""
+    if os.path.isdir(dest):
+        shutil.rmtree(dest)
+    os.makedirs(dest)
+    prefix = f'{config}-{run}-'
+    paths = []
+    for ext in ('csv', 'odm'):
+        paths += glob.glob(os.path.join(SCRIPT_DIR, 'results', f'{prefix}metrics_*_cluster*.{ext}'))
+    if not paths:
+        raise RuntimeError(f"{config} run {run} wrote no results/{prefix}metrics_*_cluster*.csv/.odm "
+                           f"(metricsFile set, or a single-cluster network?)")
+    for path in paths:
+        shutil.move(path, os.path.join(dest, os.path.basename(path)[len(prefix):]))
+
+def run_sequential(run):
+    start = time.perf_counter()
+    subprocess.run(sim_command('ParSimSequential', ['-r', str(run)]), cwd=SCRIPT_DIR,
+                   stdout=subprocess.DEVNULL, check=True)
+    return time.perf_counter() - start
+
+def run_parallel(run, num_partitions):
+    """Start one process per partition and wait for all of them"""
+    comm_dir = os.path.join(SCRIPT_DIR, 'comm')
+    shutil.rmtree(comm_dir, ignore_errors=True)
+    os.makedirs(comm_dir)
+
+    start = time.perf_counter()
+    procs = []
+    for procid in range(num_partitions):
+        result = f'results/ParSim-{run}-p{procid}'
+        extra = ['-r', str(run),
+                 f'--parsim-procid={procid}',
+                 f'--parsim-num-partitions={num_partitions}',
+                 f'--output-scalar-file={result}.sca',
+                 f'--output-vector-file={result}.vec']
+        procs.append(subprocess.Popen(sim_command('ParSim', extra), cwd=SCRIPT_DIR,
+                                      stdout=subprocess.DEVNULL))
+    codes = [p.wait() for p in procs]
+    wall = time.perf_counter() - start
+    if any(codes):
+        raise RuntimeError(f"parallel run {run} failed: exit codes {codes}")
+    return wall
+
+def identical(dir_a, dir_b):
+    files_a = sorted(os.listdir(dir_a))
+    if files_a != sorted(os.listdir(dir_b)) or not files_a:
+        return False
+    _, mismatch, errors = filecmp.cmpfiles(dir_a, dir_b, files_a, shallow=False)
+    return not mismatch and not errors
+
+def main():
+    parser = argparse.ArgumentParser(description='ODA-MD parallel simulation benchmark')
+    parser.add_argument('--gen-ini', type=int, metavar='MAX_CLUSTERS')
+    args = parser.parse_args()
+
+    if args.gen_ini:
+        generate_partition_ini(args.gen_ini)
+        return
+
+    os.makedirs(OUT_DIR, exist_ok=True)
+    rows = []
+    for run, n in enumerate(N_VALUES):
+        seq_dir = os.path.join(OUT_DIR, 'parsim', f'seq-{n}')
+        par_dir = os.path.join(OUT_DIR, 'parsim', f'par-{n}')
+
+        seq_wall = run_sequential(run)
+        collect_metrics('ParSimSequential', run, seq_dir)
+        par_wall = run_parallel(run, n + 1)
+        collect_metrics('ParSim', run, par_dir)
+
+        same = identical(seq_dir, par_dir)
+        rows.append({'clusters': n, 'partitions': n + 1,
+                     'sequential_s': round(seq_wall, 3), 'parallel_s': round(par_wall, 3),
+                     'speedup': round(seq_wall / par_wall, 2), 'identical_metrics': same})
+        print(f"N={n:3d}  seq={seq_wall:8.2f}s  par={par_wall:8.2f}s  "
+              f"speedup={seq_wall / par_wall:5.2f}x  identical={same}")
+
+    csv_file = os.path.join(OUT_DIR, 'parsim.csv')
+    with open(csv_file, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f"Saved: {csv_file}")
+
+if __name__ == "__main__":
+    main()
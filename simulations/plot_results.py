@@ -6,7 +6,12 @@ Creates cumulative detection curves showing outliers detected over time
 import pandas as pd
 import matplotlib.pyplot as plt
 import numpy as np
+import argparse
+import glob
 import os
+import re
+
+from metrics_reader import read_metrics
 
 # Get script directory (where CSV files are located)
 SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
@@ -20,11 +25,11 @@ plt.rcParams['legend.fontsize'] = 11
 plt.rcParams['figure.figsize'] = (10, 6)
 
 def load_metrics(filename):
-    """Load metrics CSV file"""
+    """Load a metrics file (CSV or columnar .odm)"""
     if not os.path.exists(filename):
         print(f"Warning: {filename} not found")
         return None
-    return pd.read_csv(filename)
+    return pd.DataFrame(read_metrics(filename))
 
 def plot_detection_accuracy(odamd_file, od_file, output_file='fig4_detection_accuracy.png'):
     """
@@ -158,10 +163,101 @@ def create_comparison_table(odamd_file, od_file):
     print(f"{'Total Outliers Detected':<25} {odamd_tp:>15} {od_tp:>15}")
     print("="*60)
 
+def find_metrics(config, name, run=None):
+    """
+    Run-unique metrics file results/<config>-<run>-<name>.csv/.odm: the given
+    run, or the most recently written one (legacy name as fallback)
+    """
+    pattern = re.compile(rf'{re.escape(config)}-(\d+)-{re.escape(name)}\.(csv|odm)$')
+    candidates = []
+    for path in glob.glob(os.path.join(SCRIPT_DIR, 'results', f'{config}-*-{name}.*')):
+        match = pattern.match(os.path.basename(path))
+        if match and (run is None or int(match.group(1)) == run):
+            candidates.append(path)
+    if candidates:
+        return max(candidates, key=os.path.getmtime)
+
+    legacy = os.path.join(SCRIPT_DIR, name + '.csv')
+    which = f'run {run}' if run is not None else 'any run'
+    print(f"Warning: no results/{config}-<run>-{name}.csv/.odm for {which}, trying {legacy}")
+    return legacy
+
+def plot_sweep(scalars_file, output_file='fig_sweep.png'):
+    """
+    Sweep summary: final DA and FAR of the CH against the threshold,
+    one curve per window size (merged table written by sweep.py)
+    """
+    df = pd.read_csv(scalars_file)
+    df = df[(df['config'] == 'Sweep') & (df['module'].str.endswith('clusterHead'))]
+    if df.empty or 'threshold' not in df.columns:
+        return
+
+    fig, (ax_da, ax_far) = plt.subplots(1, 2, figsize=(14, 5))
+    for window, group in df.groupby('window'):
+        da = group[group['name'] == 'detectionAccuracy'].sort_values('threshold')
+        far = group[group['name'] == 'falseAlarmRate'].sort_values('threshold')
+        ax_da.plot(da['threshold'], da['value'] * 100, '-o', label=f'window={window}')
+        ax_far.plot(far['threshold'], far['value'] * 100, '-o', label=f'window={window}')
+
+    ax_da.set_xlabel('MD Threshold')
+    ax_da.set_ylabel('Detection Accuracy (%)')
+    ax_far.set_xlabel('MD Threshold')
+    ax_far.set_ylabel('False Alarm Rate (%)')
+    for ax in (ax_da, ax_far):
+        ax.legend()
+        ax.grid(True, alpha=0.3)
+
+    plt.tight_layout()
+    plt.savefig(output_file, dpi=300, bbox_inches='tight')
+    print(f"Saved: {output_file}")
+    plt.close()
+
+def adaptive_sampling_table(scalars_file):
+    """
+    Adaptive vs fixed-rate polling ([Config AdaptiveSampling] via sweep.py):
+    network energy (CH + sensors) saved against DA/FAR lost
+    """
+    df = pd.read_csv(scalars_file)
+    df = df[df['config'] == 'AdaptiveSampling']
+    if df.empty or 'adaptive' not in df.columns:
+        return
+
+    rows = {}
+    for adaptive, group in df.groupby('adaptive'):
+        ch = group[group['module'].str.endswith('clusterHead')]
+        value = lambda name: ch[ch['name'] == name]['value'].astype(float).mean()
+        rows[str(adaptive)] = {
+            'energy': group[group['name'] == 'energyConsumed']['value'].astype(float).sum(),
+            'da': value('detectionAccuracy') * 100,
+            'far': value('falseAlarmRate') * 100,
+            'requests': value('requestsSent'),
+        }
+    if 'false' not in rows or 'true' not in rows:
+        return
+    fixed, adaptive = rows['false'], rows['true']
+
+    print("\n" + "="*60)
+    print("ADAPTIVE SAMPLING vs FIXED-RATE POLLING")
+    print("="*60)
+    print(f"{'Metric':<25} {'Fixed':>15} {'Adaptive':>15}")
+    print(f"{'Requests sent':<25} {fixed['requests']:>15.0f} {adaptive['requests']:>15.0f}")
+    print(f"{'Network energy (mJ)':<25} {fixed['energy']:>15.1f} {adaptive['energy']:>15.1f}")
+    print(f"{'Detection Accuracy (%)':<25} {fixed['da']:>14.2f}% {adaptive['da']:>14.2f}%")
+    print(f"{'False Alarm Rate (%)':<25} {fixed['far']:>14.2f}% {adaptive['far']:>14.2f}%")
+    saved = (1 - adaptive['energy'] / fixed['energy']) * 100 if fixed['energy'] > 0 else 0
+    print(f"Energy saved: {saved:.1f}%, DA lost: {fixed['da'] - adaptive['da']:.2f} pts, "
+          f"FAR change: {adaptive['far'] - fixed['far']:+.2f} pts")
+    print("="*60)
+
 def main():
-    # File paths (relative to script directory)
-    odamd_file = os.path.join(SCRIPT_DIR, 'metrics_odamd.csv')
-    od_file = os.path.join(SCRIPT_DIR, 'metrics_od.csv')
+    parser = argparse.ArgumentParser(description='ODA-MD vs OD comparison plots')
+    parser.add_argument('--run', type=int, default=None,
+                        help='run number of the ODAMD/OD configs (default: the latest written)')
+    args = parser.parse_args()
+
+    # Run-unique files from results/ (written by ClusterHead::finish)
+    odamd_file = find_metrics('ODAMD', 'metrics_odamd', args.run)
+    od_file = find_metrics('OD', 'metrics_od', args.run)
     
     print("Generating paper-style comparison graphs...")
     print(f"Looking for CSV files in: {SCRIPT_DIR}")
@@ -176,6 +272,12 @@ def main():
     
     # Print comparison table
     create_comparison_table(odamd_file, od_file)
+
+    # Parameter sweep (sweep.py)
+    sweep_file = os.path.join(SCRIPT_DIR, 'results', 'sweep_scalars.csv')
+    if os.path.exists(sweep_file):
+        plot_sweep(sweep_file, os.path.join(SCRIPT_DIR, 'fig_sweep.png'))
+        adaptive_sampling_table(sweep_file)
     
     print(f"\nDone! Check the generated PNG files in: {SCRIPT_DIR}")
 
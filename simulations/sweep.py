@@ -0,0 +1,118 @@
+"""
+Parameter-sweep driver for the ODA-MD simulation
+Expands the iteration variables of one or more configs in omnetpp.ini,
+runs every run as a separate Cmdenv process across all cores, and merges
+the per-run scalars (.sca) and metrics time series (CSV or .odm) into two tables:
+
+  results/sweep_scalars.csv  config, run, <itervars>, module, name, value
+  results/sweep_series.csv   config, run, <itervars>, source, Time, DA, FAR, ...
+
+Usage:  python3 sweep.py -c Sweep -c SweepOD [-j 8]
+        python3 plot_results.py            # also plots the sweep tables
+"""
+
+import argparse
+import csv
+import glob
+import os
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+from benchmark import SCRIPT_DIR, sim_command, count_runs
+from metrics_reader import iter_rows
+
+RESULT_DIR = os.path.join(SCRIPT_DIR, 'results')
+
+def run_job(config, run):
+    """Run one simulation run in its own process; return (config, run, returncode)"""
+    log_file = os.path.join(RESULT_DIR, f'{config}-{run}.log')
+    with open(log_file, 'w') as log:
+        proc = subprocess.run(sim_command(config, ['-r', str(run)]), cwd=SCRIPT_DIR,
+                              stdout=log, stderr=subprocess.STDOUT)
+    return config, run, proc.returncode
+
+def read_sca(sca_file):
+    """Return (itervars dict, list of (module, name, value)) from an .sca file"""
+    itervars, scalars = {}, []
+    with open(sca_file) as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) >= 3 and parts[0] == 'itervar':
+                itervars[parts[1]] = parts[2].strip('"')
+            elif len(parts) >= 4 and parts[0] == 'scalar':
+                scalars.append((parts[1], parts[2], parts[3]))
+    return itervars, scalars
+
+def merge_results(jobs):
+    """Merge every finished run into the two sweep tables"""
+    scalar_rows, series_rows, itervar_names = [], [], []
+
+    for config, run in jobs:
+        sca_file = os.path.join(RESULT_DIR, f'{config}-{run}.sca')
+        if not os.path.exists(sca_file):
+            print(f"Warning: {sca_file} not found", file=sys.stderr)
+            continue
+        itervars, scalars = read_sca(sca_file)
+        for name in itervars:
+            if name not in itervar_names:
+                itervar_names.append(name)
+
+        base = {'config': config, 'run': run, **itervars}
+        for module, name, value in scalars:
+            scalar_rows.append({**base, 'module': module, 'name': name, 'value': value})
+
+        prefix = f'{config}-{run}-'
+        for metrics_file in sorted(glob.glob(os.path.join(RESULT_DIR, prefix + 'metrics_*.*'))):
+            source, ext = os.path.splitext(os.path.basename(metrics_file)[len(prefix):])
+            if ext not in ('.csv', '.odm'):
+                continue
+            for row in iter_rows(metrics_file):
+                series_rows.append({**base, 'source': source, **row})
+
+    def write(filename, rows, columns):
+        path = os.path.join(RESULT_DIR, filename)
+        with open(path, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=columns, restval='')
+            writer.writeheader()
+            writer.writerows(rows)
+        print(f"Saved: {path} ({len(rows)} rows)")
+
+    key_columns = ['config', 'run'] + itervar_names
+    write('sweep_scalars.csv', scalar_rows, key_columns + ['module', 'name', 'value'])
+    series_columns = key_columns + ['source']
+    for row in series_rows:
+        for column in row:
+            if column not in series_columns:
+                series_columns.append(column)
+    write('sweep_series.csv', series_rows, series_columns)
+
+def main():
+    parser = argparse.ArgumentParser(description='ODA-MD parameter sweep')
+    parser.add_argument('-c', '--config', action='append', required=True,
+                        help='config to sweep (repeatable)')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(),
+                        help='parallel processes (default: all cores)')
+    args = parser.parse_args()
+
+    os.makedirs(RESULT_DIR, exist_ok=True)
+    jobs = [(config, run) for config in args.config for run in range(count_runs(config))]
+    print(f"Running {len(jobs)} runs on {args.jobs} cores...")
+
+    failed = []
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = [pool.submit(run_job, config, run) for config, run in jobs]
+        for future in as_completed(futures):
+            config, run, code = future.result()
+            status = 'ok' if code == 0 else f'FAILED ({code})'
+            print(f"  {config} #{run}: {status}")
+            if code != 0:
+                failed.append((config, run))
+
+    merge_results([job for job in jobs if job not in failed])
+    if failed:
+        print(f"{len(failed)} runs failed, see results/<config>-<run>.log", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,138 @@
+//
+// Binary trace of the SensorMsg arrivals at a ClusterHead (record / replay)
+// One fixed-size POD record per sample, in arrival order, as the CH saw it
+// after unpacking batched / encoded responses. Records are buffered and
+// appended a chunk at a time; there is no footer, so a reader stops at the
+// first incomplete record and a crashed run still leaves a usable trace.
+// Replayed by TraceReplaySource; decoded offline by
+// simulations/arrival_trace.py.
+//
+// File layout (native little-endian):
+//   char[4]  magic "ODAT"
+//   uint32   version (1)
+//   uint32   record size in bytes
+//   int32    simtime scale exponent (-12 = ps) of the time fields
+//   records...
+// Times are raw simtime ticks, so a replay at recorded timing reproduces
+// the arrival instants exactly.
+//
+
+#ifndef __ODAMD_ARRIVALTRACE_H_
+#define __ODAMD_ARRIVALTRACE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct ArrivalRecord {
+    int64_t arrivalTime;    // Simulation time the CH received the sample (raw ticks)
+    int64_t senseTime;      // SensorMsg.senseTime (raw ticks)
+    double temperature;
+    double humidity;
+    double light;
+    double voltage;
+    int32_t sourceId;
+    int32_t requestId;
+    int32_t seqNo;
+    uint8_t isOutlier;      // Ground truth
+    uint8_t reserved[3];
+};
+
+class ArrivalTraceWriter {
+  private:
+    static const size_t CHUNK = 1024;
+
+    FILE *file;
+    std::vector<ArrivalRecord> chunk;
+    uint64_t written;
+
+  public:
+    ArrivalTraceWriter() : file(nullptr), written(0) {}
+    ~ArrivalTraceWriter() { close(); }
+
+    ArrivalTraceWriter(const ArrivalTraceWriter&) = delete;
+    ArrivalTraceWriter& operator=(const ArrivalTraceWriter&) = delete;
+
+    bool open(const std::string& filename, int scaleExp) {
+        close();
+        file = fopen(filename.c_str(), "wb");
+        if (file == nullptr) return false;
+        uint32_t header[4] = {0, 1, (uint32_t)sizeof(ArrivalRecord), (uint32_t)scaleExp};
+        memcpy(&header[0], "ODAT", 4);
+        fwrite(header, sizeof(header), 1, file);
+        chunk.reserve(CHUNK);
+        written = 0;
+        return true;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t getCount() const { return written + chunk.size(); }
+
+    void append(const ArrivalRecord& r) {
+        if (file == nullptr) return;
+        chunk.push_back(r);
+        if (chunk.size() >= CHUNK) flush();
+    }
+
+    void flush() {
+        if (file == nullptr || chunk.empty()) return;
+        fwrite(chunk.data(), sizeof(ArrivalRecord), chunk.size(), file);
+        fflush(file);
+        written += chunk.size();
+        chunk.clear();
+    }
+
+    void close() {
+        if (file == nullptr) return;
+        flush();
+        fclose(file);
+        file = nullptr;
+    }
+};
+
+class ArrivalTraceReader {
+  private:
+    FILE *file;
+    size_t recordSize;
+    int scaleExp;
+
+  public:
+    ArrivalTraceReader() : file(nullptr), recordSize(0), scaleExp(0) {}
+    ~ArrivalTraceReader() { close(); }
+
+    ArrivalTraceReader(const ArrivalTraceReader&) = delete;
+    ArrivalTraceReader& operator=(const ArrivalTraceReader&) = delete;
+
+    // False if missing or not an arrival trace of this record layout
+    bool open(const std::string& filename) {
+        close();
+        file = fopen(filename.c_str(), "rb");
+        if (file == nullptr) return false;
+        uint32_t header[4];
+        if (fread(header, sizeof(header), 1, file) != 1 || memcmp(&header[0], "ODAT", 4) != 0
+                || header[1] != 1 || header[2] != sizeof(ArrivalRecord)) {
+            close();
+            return false;
+        }
+        recordSize = header[2];
+        scaleExp = (int32_t)header[3];
+        return true;
+    }
+
+    int getScaleExp() const { return scaleExp; }
+
+    // Next record; false at the end (or at a truncated last record)
+    bool next(ArrivalRecord& r) {
+        return file != nullptr && fread(&r, recordSize, 1, file) == 1;
+    }
+
+    void close() {
+        if (file == nullptr) return;
+        fclose(file);
+        file = nullptr;
+    }
+};
+
+#endif
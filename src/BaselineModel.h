@@ -0,0 +1,134 @@
+//
+// Precomputed baseline model for warm-started detection
+// Mean, covariance and sample count of clean readings, built offline by
+// simulations/baseline_model.py (by default from the days before the
+// simulated date range). With a baseline the CH scores from the first
+// packet: while the window fills, its samples are pooled with `weight`
+// pseudo-samples of the baseline (merge of sufficient statistics), the
+// weight shrinking as the window fills, so the model hands over to the
+// plain sliding window once it is full.
+//
+// File format (text, '#' comments):
+//   version 1
+//   count <n>
+//   mean <T> <H> <L> <V>
+//   cov <16 values, row-major, unbiased (n - 1)>
+// Unknown keys are ignored.
+//
+
+#ifndef __ODAMD_BASELINEMODEL_H_
+#define __ODAMD_BASELINEMODEL_H_
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "DetectorMath.h"
+#include "OpCount.h"
+#include "SufficientStats.h"
+
+class BaselineModel {
+  public:
+    static const int DIM = SufficientStats::DIM;
+
+  private:
+    bool loaded;
+    long count;
+    double mean[DIM];
+    double cov[DIM][DIM];
+
+    static bool readValues(std::istringstream& in, double *values, int n) {
+        for (int i = 0; i < n; i++) {
+            if (!(in >> values[i]) || !std::isfinite(values[i])) return false;
+        }
+        return true;
+    }
+
+  public:
+    BaselineModel() : loaded(false), count(0) {}
+
+    // False with a reason in error if the file is missing or incomplete
+    bool load(const std::string& filename, std::string& error) {
+        loaded = false;
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            error = "cannot open file";
+            return false;
+        }
+        int version = 0;
+        bool hasMean = false, hasCov = false;
+        count = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream in(line);
+            std::string key;
+            if (!(in >> key) || key[0] == '#') continue;
+            bool ok = true;
+            if (key == "version") ok = bool(in >> version);
+            else if (key == "count") ok = bool(in >> count);
+            else if (key == "mean") ok = hasMean = readValues(in, mean, DIM);
+            else if (key == "cov") ok = hasCov = readValues(in, &cov[0][0], DIM * DIM);
+            if (!ok) {
+                error = "malformed '" + key + "' line";
+                return false;
+            }
+        }
+        if (version != 1) {
+            error = "unsupported version " + std::to_string(version);
+            return false;
+        }
+        if (count < 2 || !hasMean || !hasCov) {
+            error = "needs count >= 2, mean and cov";
+            return false;
+        }
+        loaded = true;
+        return true;
+    }
+
+    bool isLoaded() const { return loaded; }
+    long getCount() const { return count; }
+    std::vector<double> getMean() const { return std::vector<double>(mean, mean + DIM); }
+
+    DetectorMath::Matrix getCovariance() const {
+        DetectorMath::Matrix c(DIM, std::vector<double>(DIM));
+        for (int j = 0; j < DIM; j++)
+            for (int k = 0; k < DIM; k++) c[j][k] = cov[j][k];
+        return c;
+    }
+
+    // Mean and covariance (plus the ODA-MD diagonal) of the rows of X pooled
+    // with `weight` pseudo-samples that carry the baseline mean and
+    // covariance: scatter = weight * cov + S_X + weight * n / (weight + n) * d d^T,
+    // divided by weight + n - 1. Double precision, counted as Welford updates
+    // and one merge.
+    void blend(const DetectorMath::Matrix& X, double weight,
+               std::vector<double>& mu, DetectorMath::Matrix& sigma) const {
+        SufficientStats window;
+        double x[DIM];
+        for (const std::vector<double>& row : X) {
+            for (int j = 0; j < DIM; j++) x[j] = row[j];
+            window.add(x);
+        }
+        double n = window.getCount();
+        double total = weight + n;
+        double d[DIM];
+        for (int j = 0; j < DIM; j++) d[j] = (n > 0) ? window.getMean(j) - mean[j] : 0.0;
+        double shift = (total > 0) ? weight * n / total : 0.0;
+        double dof = std::max(total - 1.0, 1.0);
+        countOps<double>(40 * (long)n + 52, 16 * (long)n + 52, 4 * (long)n + 22, 0);
+
+        mu.assign(DIM, 0.0);
+        sigma.assign(DIM, std::vector<double>(DIM));
+        for (int j = 0; j < DIM; j++) {
+            mu[j] = (total > 0) ? mean[j] + d[j] * n / total : mean[j];
+            for (int k = 0; k < DIM; k++) {
+                sigma[j][k] = (weight * cov[j][k] + window.getScatter(j, k) + shift * d[j] * d[k]) / dof;
+            }
+            sigma[j][j] += 0.001;
+        }
+    }
+};
+
+#endif
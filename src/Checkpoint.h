@@ -0,0 +1,230 @@
+//
+// Binary checkpoint of one module's state (ClusterHead, SensorNode)
+// A flat sequence of values that the module's save and restore code write
+// and read back in the same order; there is no per-field tagging, so a
+// checkpoint restores only into a build with the same layout (the version
+// is bumped whenever a module changes what it saves). Read errors are
+// sticky: after the first short read every get() leaves its argument
+// untouched and good() / finish() return false.
+//
+// File layout (native endianness):
+//   char[4]  magic "ODCK"
+//   uint32   version (3)
+//   string   module type ("ClusterHead", "SensorNode")
+//   int64    simulation time of the checkpoint (raw ticks)
+//   int32    simtime scale exponent (-12 = ps)
+//   values...
+//   char[4]  end marker "END."
+// Strings and vectors are a uint64 element count followed by the elements;
+// matrices a row count followed by the rows as vectors; maps a count
+// followed by (key, value) pairs.
+//
+
+#ifndef __ODAMD_CHECKPOINT_H_
+#define __ODAMD_CHECKPOINT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+class CheckpointWriter {
+  private:
+    static const uint32_t VERSION = 3;
+
+    FILE *file;
+    bool ok;
+
+    void write(const void *data, size_t bytes) {
+        if (ok && bytes > 0 && fwrite(data, bytes, 1, file) != 1) ok = false;
+    }
+
+  public:
+    CheckpointWriter() : file(nullptr), ok(false) {}
+    ~CheckpointWriter() { if (file != nullptr) fclose(file); }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    bool open(const std::string& filename, const std::string& moduleType, int64_t time, int scaleExp) {
+        file = fopen(filename.c_str(), "wb");
+        ok = (file != nullptr);
+        write("ODCK", 4);
+        put((uint32_t)VERSION);
+        putString(moduleType);
+        put(time);
+        put((int32_t)scaleExp);
+        return ok;
+    }
+
+    template<typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        write(&value, sizeof(T));
+    }
+
+    template<typename T>
+    void putVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        put((uint64_t)values.size());
+        write(values.data(), values.size() * sizeof(T));
+    }
+
+    // Rows of possibly different lengths (matrices)
+    template<typename T>
+    void putVectors(const std::vector<std::vector<T>>& rows) {
+        put((uint64_t)rows.size());
+        for (const auto& row : rows) putVector(row);
+    }
+
+    void putString(const std::string& s) {
+        put((uint64_t)s.size());
+        write(s.data(), s.size());
+    }
+
+    template<typename K, typename V>
+    void putMap(const std::map<K, V>& m) {
+        put((uint64_t)m.size());
+        for (const auto& kv : m) {
+            put(kv.first);
+            put(kv.second);
+        }
+    }
+
+    // End marker, flush and close; false if anything failed to write
+    bool close() {
+        if (file == nullptr) return false;
+        write("END.", 4);
+        if (fclose(file) != 0) ok = false;
+        file = nullptr;
+        return ok;
+    }
+};
+
+class CheckpointReader {
+  private:
+    static const uint32_t VERSION = 3;
+
+    FILE *file;
+    bool ok;
+    uint64_t remaining;         // Bytes left in the file (bounds element counts)
+    int64_t time;
+    int scaleExp;
+
+    void read(void *data, size_t bytes) {
+        if (!ok || bytes == 0) return;
+        if (bytes > remaining || fread(data, bytes, 1, file) != 1) {
+            ok = false;
+            return;
+        }
+        remaining -= bytes;
+    }
+
+    // Element count, rejected if the file cannot hold that many elements
+    bool getCount(uint64_t& n, size_t elementSize) {
+        n = 0;
+        get(n);
+        if (ok && elementSize > 0 && n > remaining / elementSize) ok = false;
+        return ok;
+    }
+
+  public:
+    CheckpointReader() : file(nullptr), ok(false), remaining(0), time(0), scaleExp(0) {}
+    ~CheckpointReader() { if (file != nullptr) fclose(file); }
+
+    CheckpointReader(const CheckpointReader&) = delete;
+    CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+    // False if missing, of another version or written by another module type
+    bool open(const std::string& filename, const std::string& moduleType) {
+        file = fopen(filename.c_str(), "rb");
+        if (file == nullptr) return false;
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        remaining = (size > 0) ? (uint64_t)size : 0;
+        ok = true;
+
+        char magic[4] = {0, 0, 0, 0};
+        uint32_t version = 0;
+        std::string type;
+        int32_t exp = 0;
+        read(magic, 4);
+        get(version);
+        getString(type);
+        get(time);
+        get(exp);
+        scaleExp = exp;
+        if (ok && (memcmp(magic, "ODCK", 4) != 0 || version != VERSION || type != moduleType)) ok = false;
+        return ok;
+    }
+
+    bool good() const { return ok; }
+    int64_t getTime() const { return time; }
+    int getScaleExp() const { return scaleExp; }
+
+    template<typename T>
+    void get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        T v;
+        read(&v, sizeof(T));
+        if (ok) value = v;
+    }
+
+    template<typename T>
+    void getVector(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        uint64_t n;
+        if (!getCount(n, sizeof(T))) return;
+        std::vector<T> v(n);
+        read(v.data(), n * sizeof(T));
+        if (ok) values.swap(v);
+    }
+
+    template<typename T>
+    void getVectors(std::vector<std::vector<T>>& rows) {
+        uint64_t n;
+        if (!getCount(n, sizeof(uint64_t))) return;
+        std::vector<std::vector<T>> v(n);
+        for (uint64_t i = 0; i < n && ok; i++) getVector(v[i]);
+        if (ok) rows.swap(v);
+    }
+
+    void getString(std::string& s) {
+        uint64_t n;
+        if (!getCount(n, 1)) return;
+        std::string v(n, '\0');
+        read(&v[0], n);
+        if (ok) s.swap(v);
+    }
+
+    template<typename K, typename V>
+    void getMap(std::map<K, V>& m) {
+        uint64_t n;
+        if (!getCount(n, sizeof(K) + sizeof(V))) return;
+        std::map<K, V> v;
+        for (uint64_t i = 0; i < n && ok; i++) {
+            K key;
+            V value;
+            get(key);
+            get(value);
+            v[key] = value;
+        }
+        if (ok) m.swap(v);
+    }
+
+    // Checks the end marker; true if everything was read
+    bool finish() {
+        char marker[4] = {0, 0, 0, 0};
+        read(marker, 4);
+        if (ok && memcmp(marker, "END.", 4) != 0) ok = false;
+        if (file != nullptr) fclose(file);
+        file = nullptr;
+        return ok;
+    }
+};
+
+#endif
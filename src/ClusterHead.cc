@@ -4,11 +4,68 @@
 //
 
 #include "ClusterHead.h"
+#include "SensorNode.h"
+#include "LiveGateway.h"
 #include <cmath>
 #include <algorithm>
 
 Define_Module(ClusterHead);
 
+// Confusion-matrix label for the per-sample debug log
+static const char *decisionLabel(bool actualOutlier, bool detectedAsOutlier)
+{
+    if (actualOutlier && detectedAsOutlier) return "[TP]";
+    if (actualOutlier && !detectedAsOutlier) return "[FN-MISSED!]";
+    if (!actualOutlier && detectedAsOutlier) return "[FP]";
+    return "[TN]";
+}
+
+// A sample as an arrival-trace record (arrival trace, checkpointed window)
+static ArrivalRecord sampleRecord(const SensorMsg *msg, simtime_t arrivalTime)
+{
+    ArrivalRecord r;
+    r.arrivalTime = arrivalTime.raw();
+    r.senseTime = msg->getSenseTime().raw();
+    r.temperature = msg->getTemperature();
+    r.humidity = msg->getHumidity();
+    r.light = msg->getLight();
+    r.voltage = msg->getVoltage();
+    r.sourceId = msg->getSourceId();
+    r.requestId = msg->getRequestId();
+    r.seqNo = msg->getSeqNo();
+    r.isOutlier = msg->isOutlier();
+    memset(r.reserved, 0, sizeof(r.reserved));
+    return r;
+}
+
+static SensorMsg *sampleFromRecord(const ArrivalRecord& r)
+{
+    SensorMsg *msg = new SensorMsg("SensorData");
+    msg->setSourceId(r.sourceId);
+    msg->setTemperature(r.temperature);
+    msg->setHumidity(r.humidity);
+    msg->setLight(r.light);
+    msg->setVoltage(r.voltage);
+    msg->setIsOutlier(r.isOutlier != 0);
+    msg->setSenseTime(SimTime::fromRaw(r.senseTime));
+    msg->setRequestId(r.requestId);
+    msg->setSeqNo(r.seqNo);
+    msg->setTimestamp(SimTime::fromRaw(r.arrivalTime));
+    return msg;
+}
+
+// Pending time of a timer in raw ticks (-1 = not scheduled)
+static int64_t timerTime(cMessage *timer)
+{
+    return (timer != nullptr && timer->isScheduled()) ? timer->getArrivalTime().raw() : -1;
+}
+
+ClusterHead::~ClusterHead()
+{
+    // Post-mortem: keep the trace even if the run ended with an error
+    dumpTrace();
+}
+
 void ClusterHead::loadCHData()
 {
     if (dataLoaded) return;
@@ -20,15 +77,15 @@ void ClusterHead::loadCHData()
         dataFile = "../data.txt";
     }
 
-    std::vector<int> moteIds = {1};
+    std::vector<int> moteIds = {chMoteId};
     std::string startDate = "2004-03-11";
     std::string endDate = "2004-03-14";
 
     bool loaded = chData->loadData(dataFile, moteIds, startDate, endDate);
 
     if (loaded) {
-        EV << "=== CH DATA LOADED (MoteID=1) ===\n";
-        EV << "CH readings: " << chData->getReadingsCount(1) << "\n";
+        EV << "=== CH DATA LOADED (MoteID=" << chMoteId << ") ===\n";
+        EV << "CH readings: " << chData->getReadingsCount(chMoteId) << "\n";
         // Inject exactly 1000 STRONG outliers as per paper
         chData->injectExactOutliers(1000, 5.0);  // multiplier=5.0 for strong outliers
         EV << "CH outliers injected: " << chData->getTotalOutliers() << "\n";
@@ -51,21 +108,34 @@ void ClusterHead::addCHReading()
     chMsg->setLight(reading.light);
     chMsg->setVoltage(reading.voltage);
     chMsg->setIsOutlier(reading.isOutlier);
+    chMsg->setSenseTime(simTime());
+    chMsg->setRequestId(-1);
 
     slidingWindow.push_back(chMsg);
 }
 
 void ClusterHead::initialize()
 {
-    chMoteId = 1;
+    chMoteId = par("chMoteId");
     dataLoaded = false;
     chData = nullptr;
 
     threshold = par("threshold").doubleValue();
     if (threshold <= 0) threshold = 3.338;
 
+    windowSize = par("windowSize");
+    if (windowSize < 5) windowSize = 20;  // Covariance of 4 features needs > 4 samples
+
     std::string algName = par("algorithm").stringValue();
-    if (algName == "OD") {
+    if (algName == "EWMA-MD") {
+        // Warm-up over windowSize samples, then constant-memory updates
+        algorithm = ALG_EWMA_MD;
+        double lambda = par("ewmaLambda").doubleValue();
+        if (lambda <= 0) lambda = EwmaModel::lambdaForHalfLife(par("ewmaHalfLife").doubleValue());
+        if (lambda <= 0 || lambda >= 1) throw cRuntimeError("EWMA-MD forgetting factor must be in (0, 1), got %g", lambda);
+        ewma.configure(lambda, windowSize, par("ewmaRefreshInterval").intValue());
+        refEwma.configure(lambda, windowSize, par("ewmaRefreshInterval").intValue());
+    } else if (algName == "OD") {
         algorithm = ALG_OD;
         threshold = par("odThreshold").doubleValue();
         if (threshold <= 0) threshold = 15.0;
@@ -73,19 +143,125 @@ void ClusterHead::initialize()
         // OD Algorithm: Fixed-width clustering parameter
         clusterWidth = par("clusterWidth").doubleValue();
         if (clusterWidth <= 0) clusterWidth = 50.0;  // Default cluster width
+    } else if (algName == "MCD-MD") {
+        // Sliding window as ODA-MD, robust model of the window
+        algorithm = ALG_MCD_MD;
+    } else if (algName == "LOF") {
+        // Sliding window as ODA-MD, density-based score
+        algorithm = ALG_LOF;
+        threshold = par("lofThreshold").doubleValue();
+        if (threshold <= 0) threshold = 1.5;
+        int lofK = par("lofK");
+        if (lofK < 1 || lofK >= windowSize)
+            throw cRuntimeError("lofK must be in [1, windowSize), got %d", lofK);
+        std::vector<double> scale = cStringTokenizer(par("lofFeatureScale").stringValue()).asDoubleVector();
+        if (scale.size() != IncrementalLof::DIM || *std::min_element(scale.begin(), scale.end()) <= 0)
+            throw cRuntimeError("lofFeatureScale needs 4 positive values (T H L V), got '%s'",
+                                par("lofFeatureScale").stringValue());
+        lofIndex.configure(lofK, scale.data());
     } else {
         algorithm = ALG_ODA_MD;
     }
+    mcdCSteps = std::max(0, (int)par("mcdCSteps").intValue());
+    mcdInitialCSteps = std::max(mcdCSteps, (int)par("mcdInitialCSteps").intValue());
+    mcdSubsetFraction = par("mcdSubsetFraction").doubleValue();
+    if (mcdSubsetFraction < 0 || mcdSubsetFraction > 1)
+        throw cRuntimeError("mcdSubsetFraction must be in [0, 1], got %g", mcdSubsetFraction);
+    mcdSubset.clear();
+    lofSlots.clear();
+    mcdFits = 0;
+    mcdStepsRun = 0;
+
+    if (par("useRealData").boolValue()) {
+        loadCHData();
+    }
 
-    loadCHData();
+    // Per-source models: windows in one arena (ODA-MD), or one EwmaModel per
+    // slot copied from the configured pooled model, which stays unused
+    perSourceModels = par("perSourceModels").boolValue();
+    if (perSourceModels && (algorithm == ALG_OD || algorithm == ALG_MCD_MD || algorithm == ALG_LOF))
+        throw cRuntimeError("perSourceModels is not supported with the %s algorithm", algName.c_str());
+    sourceArena.configure(algorithm == ALG_ODA_MD ? windowSize : 0);
+    sourceEwma.clear();
+    sourceRefEwma.clear();
+
+    // Arithmetic of the detector kernels; anything but double is shadowed by
+    // the double path for the accuracy report
+    std::string numericType = par("numericType").stdstringValue();
+    if (!DetectorMath::selectKernels(numericType, kernels)) {
+        throw cRuntimeError("Unknown numericType '%s' (double, float, q16.16, q8.24)", numericType.c_str());
+    }
+    DetectorMath::selectKernels("double", reference);
+    shadowReference = (numericType != "double");
+    if (shadowReference && algorithm == ALG_LOF)
+        throw cRuntimeError("The LOF detector runs in double only (numericType = \"double\")");
+    refValid = false;
+    mdError.setName("mdError");
+    decisionFlips = 0;
+    fixedSaturations = 0;
+    takeSaturations();
+
+    // Stage names for the hot-path timers (must follow enum ProfileStage)
+    const char *stageNames[NUM_PROFILE_STAGES] = {
+        "windowToMatrix", "mean", "covariance", "inversion", "mahalanobis",
+        "metrics", "send", "odClustering", "odDetection", "odClassification",
+        "lofUpdate", "packetTotal"
+    };
+    for (int i = 0; i < NUM_PROFILE_STAGES; i++) {
+        profiler.addStage(stageNames[i]);
+    }
 
     energy = EnergyModel(5.0);
 
     totalPacketsReceived = 0;
     totalOutliersDetected = 0;
     totalPacketsForwarded = 0;
+    batchesReceived = 0;
+    decoders.clear();
+    encodedReceived = 0;
+    encodedBits = 0;
+    decodeErrors = 0;
+    eventsHandled = 0;
+
+    // Binary decision trace ring (post-mortem dumps, decode_trace.py)
+    trace.setCapacity(par("traceRingSize").intValue());
+    traceFile = par("traceFile").stdstringValue();
+    if (traceFile.empty()) traceFile = runOutputPath("trace" + clusterSuffix() + ".bin");
+    traceDumped = false;
+
+    // Arrival trace: the sample stream as seen here, for TraceReplaySource
+    if (par("recordArrivals").boolValue()) {
+        std::string arrivalFile = par("arrivalTraceFile").stdstringValue();
+        if (arrivalFile.empty()) arrivalFile = runOutputPath("arrivals" + clusterSuffix() + ".bin");
+        if (!arrivals.open(arrivalFile, SimTime::getScaleExp()))
+            throw cRuntimeError("Cannot write arrival trace '%s'", arrivalFile.c_str());
+    }
     isInitialWindowProcessed = false;  // First 20 samples not yet processed
 
+    // Warm start from a precomputed baseline (simulations/baseline_model.py)
+    baselineWeight = 0;
+    std::string baselineFile = par("baselineModel").stdstringValue();
+    if (!baselineFile.empty()) {
+        if (algorithm != ALG_ODA_MD && algorithm != ALG_EWMA_MD)
+            throw cRuntimeError("baselineModel is supported with ODA-MD and EWMA-MD only");
+        std::string error;
+        if (!baseline.load(baselineFile, error))
+            throw cRuntimeError("Cannot load baseline model '%s': %s", baselineFile.c_str(), error.c_str());
+        baselineWeight = par("baselineWeight").doubleValue();
+        if (baselineWeight < 0) baselineWeight = windowSize;
+        baselineWeight = std::min(baselineWeight, (double)baseline.getCount());
+        if (algorithm == ALG_EWMA_MD) {
+            // Per-source models start as copies of this one, so they are warm too
+            if (!ewma.seed(kernels, baseline.getMean(), baseline.getCovariance()))
+                throw cRuntimeError("Baseline model '%s' has a singular covariance", baselineFile.c_str());
+            refEwma.seed(reference, baseline.getMean(), baseline.getCovariance());
+        }
+        isInitialWindowProcessed = true;  // Scored on arrival: no initial all-window pass
+        EV << "CH: baseline model " << baselineFile << " (" << baseline.getCount()
+           << " samples, weight " << baselineWeight << ")\n";
+    }
+    firstDecisionTime = -1;
+
     logInterval = par("logInterval").doubleValue();
     if (logInterval <= 0) logInterval = 100.0;
 
@@ -97,19 +273,146 @@ void ClusterHead::initialize()
     if (requestInterval <= 0) requestInterval = 1.0;
     numSensors = gateSize("toSensor");
     requestId = 0;
+    pendingRounds.clear();
+    incompleteRounds = 0;
+    senseToDecisionSignal = registerSignal("senseToDecision");
+    roundCompletionSignal = registerSignal("roundCompletionTime");
+    liveGateway = nullptr;
+    for (int i = 0; i < gateSize("in") && liveGateway == nullptr; i++) {
+        liveGateway = dynamic_cast<LiveGateway *>(gate("in", i)->getPathStartGate()->getOwnerModule());
+    }
+
+    // CPU service queue (MICA2 processing delay per detection)
+    modelProcessingDelay = par("modelProcessingDelay").boolValue();
+    queueCapacity = par("queueCapacity");
+    serviceQueue.setName("serviceQueue");
+    serviceTimer = new cMessage("serviceTimer");
+    inService = false;
+    serviceCycles = 0;
+    totalOps.reset();
+    totalCycles = 0;
+    busyTime = SIMTIME_ZERO;
+    droppedPackets = 0;
+    droppedOutliers = 0;
+    queueLengthSignal = registerSignal("queueLength");
+    queueingTimeSignal = registerSignal("queueingTime");
+    serviceTimeSignal = registerSignal("serviceTime");
+    droppedSignal = registerSignal("dropped");
+    emit(queueLengthSignal, 0);
+
+    // Round batching (one model update per request round)
+    roundBatching = par("roundBatching").boolValue();
+    if (roundBatching && numSensors == 0)
+        throw cRuntimeError("roundBatching needs request rounds, but no sensors are connected (trace replay?)");
+    roundDeadline = par("roundDeadline").doubleValue();
+    roundDeadlineTimer = new cMessage("roundDeadlineTimer");
+    openRoundId = -1;
+    roundResponses = 0;
+    roundsProcessed = 0;
+    roundSamples = 0;
+    roundsClosedIncomplete = 0;
+    lateResponses = 0;
     
     requestTimer = new cMessage("requestTimer");
     scheduleAt(simTime() + 0.1, requestTimer);  // First request after 0.1s
 
+    // Adaptive sampling (bounded, with hysteresis)
+    adaptiveSampling = par("adaptiveSampling").boolValue();
+    minRequestInterval = par("minRequestInterval").doubleValue();
+    maxRequestInterval = par("maxRequestInterval").doubleValue();
+    if (minRequestInterval <= 0) minRequestInterval = requestInterval;
+    if (maxRequestInterval < minRequestInterval) maxRequestInterval = minRequestInterval;
+    adaptFactor = par("adaptFactor").doubleValue();
+    if (adaptFactor <= 1.0) adaptFactor = 2.0;
+    stableRounds = par("stableRounds");
+    stableScoreFraction = par("stableScoreFraction").doubleValue();
+    unstableScoreFraction = par("unstableScoreFraction").doubleValue();
+    covChangeTolerance = par("covChangeTolerance").doubleValue();
+    stableCount = 0;
+    adaptMaxScore = 0;
+    adaptOutliers = 0;
+    windowCov.clear();
+    adaptCov.clear();
+    requestTimeTotal = 0;
+    requestIntervalSignal = registerSignal("requestInterval");
+    if (adaptiveSampling) {
+        requestInterval = std::min(std::max(requestInterval, minRequestInterval), maxRequestInterval);
+    }
+    emit(requestIntervalSignal, requestInterval);
+
+    // CH-side aggregation (summaries instead of per-sample forwarding)
+    aggregation = par("aggregation").boolValue();
+    aggregationInterval = par("aggregationInterval").doubleValue();
+    if (aggregationInterval <= 0) aggregationInterval = 20.0;
+    totalSummariesSent = 0;
+    intervalStats.reset();
+    intervalOutliers.clear();
+    intervalStart = simTime();
+    aggregationTimer = nullptr;
+    if (aggregation) {
+        aggregationTimer = new cMessage("aggregationTimer");
+        scheduleAt(simTime() + aggregationInterval, aggregationTimer);
+    }
+
+    // Multi-cluster: periodic local model reports, optional global-model decisions
+    modelReportInterval = par("modelReportInterval").doubleValue();
+    std::string detectionModel = par("detectionModel").stringValue();
+    useGlobalModel = (detectionModel == "global");
+    hasGlobalModel = false;
+    modelReportTimer = nullptr;
+    if (modelReportInterval > 0) {
+        modelReportTimer = new cMessage("modelReportTimer");
+        scheduleAt(simTime() + modelReportInterval, modelReportTimer);
+    }
+
+    // Metrics file: run-unique per-algorithm name, suffixed with the cluster
+    // index when this CH is one of several clusters inside a compound module
+    MetricsWriter::Format metricsFormat;
+    if (!MetricsWriter::parseFormat(par("metricsFormat").stdstringValue(), metricsFormat))
+        throw cRuntimeError("Unknown metricsFormat '%s' (csv, columnar)", par("metricsFormat").stringValue());
+    metricsFile = par("metricsFile").stringValue();
+    if (metricsFile.empty()) {
+        std::string name = (algorithm == ALG_ODA_MD) ? "metrics_odamd"
+                         : (algorithm == ALG_EWMA_MD) ? "metrics_ewmamd"
+                         : (algorithm == ALG_MCD_MD) ? "metrics_mcdmd"
+                         : (algorithm == ALG_LOF) ? "metrics_lof" : "metrics_od";
+        metricsFile = runOutputPath(name + clusterSuffix() + MetricsWriter::extension(metricsFormat));
+    }
+    metrics.setRollingWindows(par("rollingDecisions").intValue(), par("rollingInterval").doubleValue(),
+                              par("rollingBuckets").intValue());
+    if (!metrics.openLog(metricsFile, metricsFormat, par("metricsChunkRows").intValue()))
+        EV_WARN << "CH: cannot open metrics file " << metricsFile << ", time series not written\n";
+
+    // Checkpoint / restore: resume from restoreDir after the normal setup
+    // (parameters of this run, state of the checkpointed one)
+    checkpointDir = par("checkpointDir").stdstringValue();
+    checkpointTimer = new cMessage("checkpointTimer");
+    checkpointTimer->setSchedulingPriority(1);  // After the zero-delay request / response exchange
+    simtime_t resumeAt = SIMTIME_ZERO;
+    std::string restoreDir = par("restoreDir").stdstringValue();
+    if (!restoreDir.empty()) {
+        resumeAt = restoreCheckpoint(checkpointPath(restoreDir, this));
+    }
+    simtime_t checkpointAt = par("checkpointAt").doubleValue();
+    if (checkpointAt > resumeAt) {
+        scheduleAt(checkpointAt, checkpointTimer);
+    }
+
     EV << "ClusterHead initialized: algorithm="
-       << (algorithm == ALG_ODA_MD ? "ODA-MD" : "OD")
+       << (algorithm == ALG_ODA_MD ? "ODA-MD" : algorithm == ALG_EWMA_MD ? "EWMA-MD"
+           : algorithm == ALG_MCD_MD ? "MCD-MD" : algorithm == ALG_LOF ? "LOF" : "OD")
        << ", threshold=" << threshold
-       << ", windowSize=" << WINDOW_SIZE
-       << ", numSensors=" << numSensors << "\n";
+       << ", windowSize=" << windowSize
+       << ", numSensors=" << numSensors
+       << ", aggregation=" << (aggregation ? "on" : "off")
+       << ", processingDelay=" << (modelProcessingDelay ? "on" : "off")
+       << ", roundBatching=" << (roundBatching ? "on" : "off") << "\n";
 }
 
 void ClusterHead::handleMessage(cMessage *msg)
 {
+    eventsHandled++;
+
     if (msg == logTimer) {
         metrics.logMetrics(simTime());
 
@@ -120,41 +423,446 @@ void ClusterHead::handleMessage(cMessage *msg)
         scheduleAt(simTime() + logInterval, logTimer);
         return;
     }
+
+    if (msg == checkpointTimer) {
+        writeCheckpoint();
+        return;
+    }
     
     // Handle request timer - send requests to all sensors (Algorithm 1)
     if (msg == requestTimer) {
         sendDataRequest();
+        if (adaptiveSampling) adaptRequestInterval();
+        requestTimeTotal += requestInterval;
         scheduleAt(simTime() + requestInterval, requestTimer);
         return;
     }
 
+    if (msg == aggregationTimer) {
+        sendSummary();
+        scheduleAt(simTime() + aggregationInterval, aggregationTimer);
+        return;
+    }
+
+    if (msg == modelReportTimer) {
+        sendModelReport();
+        scheduleAt(simTime() + modelReportInterval, modelReportTimer);
+        return;
+    }
+
+    if (msg == serviceTimer) {
+        endService();
+        startNextJob();
+        return;
+    }
+
+    if (msg == roundDeadlineTimer) {
+        closeRound(false);
+        return;
+    }
+
+    if (ModelMsg *model = dynamic_cast<ModelMsg *>(msg)) {
+        handleGlobalModel(model);
+        delete model;
+        return;
+    }
+
+    if (SensorBatchMsg *batch = dynamic_cast<SensorBatchMsg *>(msg)) {
+        std::vector<SensorMsg *> samples = unpackBatch(batch);
+        delete batch;
+        acceptResponse(samples);
+        return;
+    }
+
+    if (EncodedSensorMsg *encoded = dynamic_cast<EncodedSensorMsg *>(msg)) {
+        std::vector<SensorMsg *> samples = decodeResponse(encoded);
+        delete encoded;
+        acceptResponse(samples);
+        return;
+    }
+
     SensorMsg *sMsg = check_and_cast<SensorMsg *>(msg);
-    totalPacketsReceived++;
     energy.receive(256);
+    std::vector<SensorMsg *> samples(1, sMsg);
+    acceptResponse(samples);
+}
+
+// Readings of a batched response as SensorMsgs, oldest first
+std::vector<SensorMsg *> ClusterHead::unpackBatch(SensorBatchMsg *batch)
+{
+    int k = batch->getSamplesArraySize();
+    energy.receive(96 + 160 * k);  // Same payload layout as SensorNode::respondBatch
+    batchesReceived++;
+
+    std::vector<SensorMsg *> samples;
+    samples.reserve(k);
+    for (int i = 0; i < k; i++) {
+        const SampleRecord& r = batch->getSamples(i);
+        SensorMsg *s = new SensorMsg("SensorData");
+        s->setSourceId(batch->getSourceId());
+        s->setTemperature(r.temperature);
+        s->setHumidity(r.humidity);
+        s->setLight(r.light);
+        s->setVoltage(r.voltage);
+        s->setIsOutlier(r.isOutlier);
+        s->setSenseTime(r.senseTime);
+        s->setRequestId(batch->getRequestId());
+        s->setSeqNo(r.seqNo);
+        samples.push_back(s);
+    }
+    return samples;
+}
+
+// Decoded readings of a compact response as SensorMsgs, oldest first
+std::vector<SensorMsg *> ClusterHead::decodeResponse(EncodedSensorMsg *encoded)
+{
+    int bytes = encoded->getPayloadArraySize();
+    int bits = PayloadCodec::packetBits(bytes);
+    energy.receive(bits);
+    encodedReceived++;
+    encodedBits += bits;
+
+    std::vector<uint8_t> payload(bytes);
+    for (int i = 0; i < bytes; i++) payload[i] = encoded->getPayload(i);
+
+    std::vector<SensorMsg *> samples;
+    std::vector<std::vector<double>> readings;
+    PayloadCodec::State& decoder = decoders[encoded->getSourceId()];
+    if (!PayloadCodec::decode(decoder, payload, readings)
+            || readings.size() != encoded->getOutlierFlagsArraySize()) {
+        EV_WARN << "CH: undecodable payload from mote " << encoded->getSourceId()
+                << " (" << bytes << " bytes), dropped\n";
+        decodeErrors++;
+        decoder = PayloadCodec::State();  // Deltas fail until the next absolute record (payloadRefreshInterval)
+        return samples;
+    }
+
+    samples.reserve(readings.size());
+    for (size_t i = 0; i < readings.size(); i++) {
+        SensorMsg *s = new SensorMsg("SensorData");
+        s->setSourceId(encoded->getSourceId());
+        s->setTemperature(readings[i][0]);
+        s->setHumidity(readings[i][1]);
+        s->setLight(readings[i][2]);
+        s->setVoltage(readings[i][3]);
+        s->setIsOutlier(encoded->getOutlierFlags(i));
+        s->setSenseTime(encoded->getSenseTimes(i));
+        s->setRequestId(encoded->getRequestId());
+        s->setSeqNo(encoded->getFirstSeqNo() + i);
+        samples.push_back(s);
+    }
+    return samples;
+}
+
+void ClusterHead::acceptResponse(std::vector<SensorMsg *>& samples)
+{
+    if (samples.empty()) return;
+    if (arrivals.isOpen()) {
+        for (SensorMsg *s : samples) recordArrival(s);
+    }
+    totalPacketsReceived += samples.size();
+    trackRoundResponse(samples.front());  // One response per sensor and round
+
+    if (roundBatching) {
+        collectRoundResponse(samples);
+        return;
+    }
+    for (SensorMsg *s : samples) {
+        acceptSample(s);
+    }
+}
+
+void ClusterHead::recordArrival(SensorMsg *msg)
+{
+    arrivals.append(sampleRecord(msg, simTime()));
+}
+
+void ClusterHead::acceptSample(SensorMsg *sMsg)
+{
+    sMsg->setTimestamp(simTime());  // Queueing time reference
+
+    if (!modelProcessingDelay) {
+        processSample(sMsg);
+        return;
+    }
+
+    // CPU busy: wait in the queue, or drop when the buffer is full
+    if (serviceTimer->isScheduled()) {
+        if (queueCapacity > 0 && serviceQueue.getLength() >= queueCapacity) {
+            EV_DEBUG << "Queue full, dropping sample from Node" << sMsg->getSourceId() << "\n";
+            droppedPackets++;
+            if (sMsg->isOutlier()) droppedOutliers++;
+            emit(droppedSignal, 1);
+            delete sMsg;
+            return;
+        }
+        serviceQueue.insert(sMsg);
+        emit(queueLengthSignal, serviceQueue.getLength());
+        return;
+    }
+
+    startService(sMsg);
+}
+
+// =============================================================================
+// CPU SERVICE QUEUE
+// The detection runs when service starts (state as of that moment), but its
+// outputs are held until the MICA2 delay of the charged operations elapses,
+// so forwarding and decision latency include processing and queueing time.
+// =============================================================================
+void ClusterHead::startService(SensorMsg *msg)
+{
+    emit(queueingTimeSignal, simTime() - msg->getTimestamp());
+    beginService();
+    processSample(msg);
+    scheduleServiceEnd();
+}
+
+void ClusterHead::startRoundService(ReadyRound& round)
+{
+    emit(queueingTimeSignal, simTime() - round.readyAt);
+    beginService();
+    processRound(round.samples);
+    scheduleServiceEnd();
+}
+
+// Closed rounds first (round batching), then single samples
+void ClusterHead::startNextJob()
+{
+    if (serviceTimer->isScheduled()) return;
+
+    if (!readyRounds.empty()) {
+        ReadyRound round = readyRounds.front();
+        readyRounds.pop_front();
+        emit(queueLengthSignal, (long)readyRounds.size());
+        startRoundService(round);
+    } else if (!serviceQueue.isEmpty()) {
+        SensorMsg *next = check_and_cast<SensorMsg *>(serviceQueue.pop());
+        emit(queueLengthSignal, serviceQueue.getLength());
+        startService(next);
+    }
+}
+
+void ClusterHead::beginService()
+{
+    inService = true;
+    serviceCycles = 0;
+}
+
+void ClusterHead::scheduleServiceEnd()
+{
+    inService = false;
+    simtime_t serviceTime = energy.getCycleDelaySeconds(serviceCycles);
+    busyTime += serviceTime;
+    emit(serviceTimeSignal, serviceTime);
+    scheduleAt(simTime() + serviceTime, serviceTimer);
+}
+
+void ClusterHead::endService()
+{
+    for (cMessage *out : heldOutput) {
+        send(out, "out");
+    }
+    heldOutput.clear();
+
+    for (const Decision& d : heldDecisions) {
+        noteDecision(d);
+    }
+    heldDecisions.clear();
+}
+
+void ClusterHead::chargeProcessing(double cycles)
+{
+    energy.processCycles(cycles);
+    if (inService) serviceCycles += cycles;
+}
+
+// Energy and CPU time of the detector arithmetic since the last charge,
+// counted by the DetectorMath kernels (analytic or measured, see OpCount.h)
+// and priced with the cycle costs of the selected numeric type
+void ClusterHead::chargeKernelOps()
+{
+    OpCounts ops = takeOps();
+    double cycles = kernels.costs.cycles(ops);
+    totalOps += ops;
+    totalCycles += cycles;
+    fixedSaturations += takeSaturations();
+    chargeProcessing(cycles);
+}
+
+void ClusterHead::sendToSink(cMessage *msg)
+{
+    if (inService) {
+        heldOutput.push_back(msg);
+    } else {
+        send(msg, "out");
+    }
+}
+
+void ClusterHead::noteDecision(const Decision& d)
+{
+    if (inService) {
+        heldDecisions.push_back(d);
+        return;
+    }
+    simtime_t latency = simTime() - d.senseTime;
+    emit(senseToDecisionSignal, latency);
+    decisionLatency.record(d.sourceId, latency);
+    if (liveGateway != nullptr) liveGateway->decisionReleased(d.sourceId, d.seqNo, d.score, d.detectedAsOutlier);
+}
+
+// =============================================================================
+// ROUND BATCHING
+// One covariance/inversion per request round instead of one per response:
+// O(model + N * score) instead of O(N * model) for N sensors.
+// =============================================================================
+void ClusterHead::collectRoundResponse(std::vector<SensorMsg *>& samples)
+{
+    // Late response (round already closed) or CH reading: a round of its own
+    if (samples.front()->getRequestId() != openRoundId) {
+        lateResponses++;
+        dispatchRound(samples);
+        return;
+    }
+
+    roundBatch.insert(roundBatch.end(), samples.begin(), samples.end());
+    if (++roundResponses >= numSensors) {
+        closeRound(true);
+    }
+}
+
+void ClusterHead::closeRound(bool complete)
+{
+    cancelEvent(roundDeadlineTimer);
+    openRoundId = -1;
+    roundResponses = 0;
+    if (roundBatch.empty()) return;
+    if (!complete) roundsClosedIncomplete++;
+
+    std::vector<SensorMsg *> samples;
+    samples.swap(roundBatch);
+    dispatchRound(samples);
+}
+
+// Process a closed round now, or queue it for the CPU (modelProcessingDelay)
+void ClusterHead::dispatchRound(std::vector<SensorMsg *>& samples)
+{
+    if (!modelProcessingDelay) {
+        processRound(samples);
+        return;
+    }
+
+    if (queueCapacity > 0 && (int)readyRounds.size() >= queueCapacity) {
+        EV_DEBUG << "Queue full, dropping round of " << samples.size() << " samples\n";
+        droppedPackets += samples.size();
+        emit(droppedSignal, (long)samples.size());
+        for (SensorMsg *m : samples) {
+            if (m->isOutlier()) droppedOutliers++;
+            delete m;
+        }
+        return;
+    }
+
+    ReadyRound round;
+    round.readyAt = simTime();
+    round.samples = samples;
+    readyRounds.push_back(round);
+    emit(queueLengthSignal, (long)readyRounds.size());
+    startNextJob();
+}
+
+void ClusterHead::processRound(std::vector<SensorMsg *>& samples)
+{
+    PROFILE_STAGE(profiler, STAGE_PACKET_TOTAL);
+    takeOps();  // Start this round's operation count from zero
+
+    roundsProcessed++;
+    roundSamples += samples.size();
+    if (perSourceModels) {
+        for (SensorMsg *m : samples) runPerSource(m);
+        chargeKernelOps();
+        return;
+    }
+    if (algorithm == ALG_EWMA_MD) {
+        for (SensorMsg *m : samples) runEWMAMD(m);  // No window: one update per sample
+        chargeKernelOps();
+        return;
+    }
+    for (SensorMsg *m : samples) {
+        slidingWindow.push_back(m);
+    }
+
+    int newSamples = std::min((int)samples.size(), windowSize);
+    if (algorithm == ALG_OD) {
+        if ((int)slidingWindow.size() >= windowSize) {
+            runOD();  // Batch over the whole buffer, clears it
+        }
+    } else if (!isInitialWindowProcessed) {
+        // Initial window scores every buffered sample, so trim only afterwards
+        if ((int)slidingWindow.size() >= windowSize) {
+            if (algorithm == ALG_LOF) runLOF(newSamples);
+            else runODAMD(newSamples);
+            while ((int)slidingWindow.size() > windowSize) {
+                delete slidingWindow.front();
+                slidingWindow.pop_front();
+            }
+        }
+    } else {
+        while ((int)slidingWindow.size() > windowSize) {
+            delete slidingWindow.front();
+            slidingWindow.pop_front();
+        }
+        if (algorithm == ALG_LOF) runLOF(newSamples);
+        else runODAMD(newSamples);
+    }
+    chargeKernelOps();
+}
+
+void ClusterHead::processSample(SensorMsg *sMsg)
+{
+    PROFILE_STAGE(profiler, STAGE_PACKET_TOTAL);
+    takeOps();  // Start this sample's operation count from zero
 
     // =========================================================================
     // SLIDING WINDOW MECHANISM (Real-time processing)
     // - Push new sample to the end of the window
-    // - If window exceeds WINDOW_SIZE, remove oldest sample (pop_front)
-    // - Process immediately when window is full (WINDOW_SIZE samples)
+    // - If window exceeds windowSize, remove oldest sample (pop_front)
+    // - Process immediately when window is full (windowSize samples)
+    // EWMA-MD keeps no window: the sample is scored and folded into the model
+    // Per-source models score the sample against its own source's model
     // =========================================================================
-    
+
+    if (perSourceModels) {
+        runPerSource(sMsg);
+        chargeKernelOps();
+        return;
+    }
+    if (algorithm == ALG_EWMA_MD) {
+        runEWMAMD(sMsg);
+        chargeKernelOps();
+        return;
+    }
+
     slidingWindow.push_back(sMsg);
     
     // Remove oldest sample if window exceeds size
-    if ((int)slidingWindow.size() > WINDOW_SIZE) {
+    if ((int)slidingWindow.size() > windowSize) {
         // Delete the oldest message to prevent memory leak
         delete slidingWindow.front();
         slidingWindow.pop_front();
     }
     
-    // Process immediately when window has exactly WINDOW_SIZE samples
-    if ((int)slidingWindow.size() == WINDOW_SIZE) {
-        if (algorithm == ALG_ODA_MD) {
-            runODAMD();  // Real-time: process the newest sample immediately
+    // Process immediately when window has exactly windowSize samples
+    // (from the first sample on with a baseline model)
+    if ((int)slidingWindow.size() == windowSize || baseline.isLoaded()) {
+        if (algorithm == ALG_LOF) {
+            runLOF();
+        } else if (algorithm != ALG_OD) {
+            runODAMD();  // Real-time: process the newest sample immediately (ODA-MD, MCD-MD)
         } else {
             runOD();     // OD still uses batch processing
         }
+        chargeKernelOps();
     }
 }
 
@@ -165,43 +873,86 @@ void ClusterHead::handleMessage(cMessage *msg)
 // - After initial 20: Calculate MD for NEWEST sample only, block/forward accordingly
 // - All samples stay in window for error/event classification
 // =============================================================================
-void ClusterHead::runODAMD()
+void ClusterHead::runODAMD(int newSamples)
 {
     int n = slidingWindow.size();
-    if (n < WINDOW_SIZE) return;  // Wait until window is full
+    if (n < windowSize && !baseline.isLoaded()) return;  // Wait until window is full
 
     // Convert sliding window to data matrix
     std::vector<std::vector<double>> X(n, std::vector<double>(4));
-    for (int i = 0; i < n; i++) {
-        X[i][0] = slidingWindow[i]->getTemperature();
-        X[i][1] = slidingWindow[i]->getHumidity();
-        X[i][2] = slidingWindow[i]->getLight();
-        X[i][3] = slidingWindow[i]->getVoltage();
+    {
+        PROFILE_STAGE(profiler, STAGE_WINDOW_TO_MATRIX);
+        for (int i = 0; i < n; i++) {
+            X[i][0] = slidingWindow[i]->getTemperature();
+            X[i][1] = slidingWindow[i]->getHumidity();
+            X[i][2] = slidingWindow[i]->getLight();
+            X[i][3] = slidingWindow[i]->getVoltage();
+        }
     }
 
-    // STEP 1: Calculate Mean from current window (slides with new data)
-    std::vector<double> mu = calculateMean(X);
-    
-    // STEP 2: Calculate Covariance from current window
-    std::vector<std::vector<double>> Sigma = calculateCovariance(X, mu);
-
-    // STEP 3: Invert Covariance matrix
+    std::vector<double> mu;
+    std::vector<std::vector<double>> Sigma;
     std::vector<std::vector<double>> InvSigma(4, std::vector<double>(4));
-    bool success = invertMatrix4x4(Sigma, InvSigma);
+    bool success;
+    McdEstimator::Model mcd;
+
+    if (algorithm == ALG_MCD_MD) {
+        // MCD-MD: robust mean / covariance / inverse of the window in one
+        // fit (also builds the shadow); the MDs of all samples come with it
+        {
+            PROFILE_STAGE(profiler, STAGE_COVARIANCE);
+            success = fitMcdModel(X, mcd);
+        }
+        mu = mcd.mean;
+        Sigma = mcd.cov;
+        InvSigma = mcd.invCov;
+    } else if (n < windowSize) {
+        // Warm start: the filling window pooled with the baseline, whose
+        // weight fades out as the window fills
+        {
+            PROFILE_STAGE(profiler, STAGE_COVARIANCE);
+            baseline.blend(X, baselineWeight * (windowSize - n) / windowSize, mu, Sigma);
+        }
+        {
+            PROFILE_STAGE(profiler, STAGE_INVERSION);
+            success = invertMatrix4x4(Sigma, InvSigma);
+        }
+        if (shadowReference) setReferenceModel(mu, Sigma);
+    } else {
+        // STEP 1: Calculate Mean from current window (slides with new data)
+        {
+            PROFILE_STAGE(profiler, STAGE_MEAN);
+            mu = calculateMean(X);
+        }
+
+        // STEP 2: Calculate Covariance from current window
+        {
+            PROFILE_STAGE(profiler, STAGE_COVARIANCE);
+            Sigma = calculateCovariance(X, mu);
+        }
+
+        // STEP 3: Invert Covariance matrix
+        {
+            PROFILE_STAGE(profiler, STAGE_INVERSION);
+            success = invertMatrix4x4(Sigma, InvSigma);
+        }
+
+        if (shadowReference) buildReferenceModel(X);
+    }
+    if (adaptiveSampling) windowCov = Sigma;
 
     if (!success) {
-        EV << "Warning: Singular Matrix!\n";
-        // For newest sample only - forward without detection
-        SensorMsg* newestMsg = slidingWindow.back();
-        metrics.recordDetection(newestMsg->isOutlier(), false);
-        send(newestMsg->dup(), "out");  // Send a copy (original stays in window)
-        totalPacketsForwarded++;
+        EV_DEBUG << "Singular covariance, " << newSamples << " sample(s) forwarded unscored\n";
+        // For newest sample(s) only - forward without detection
+        for (int idx = n - newSamples; idx < n; idx++) {
+            SensorMsg* newestMsg = slidingWindow[idx];
+            if (shadowReference) compareWithReference(newestMsg, X[idx], 0.0, false);
+            recordDecision(newestMsg, 0.0, false, "SINGULAR");
+            forwardClean(newestMsg);  // Send a copy (original stays in window)
+        }
         return;
     }
 
-    // Energy consumption for matrix computation
-    energy.process(1000);  // ~1000 FLOPs for 4x4 matrix inversion
-
     // =========================================================================
     // HYBRID DETECTION LOGIC
     // =========================================================================
@@ -211,92 +962,320 @@ void ClusterHead::runODAMD()
         // INITIAL WINDOW: Calculate MD for ALL 20 samples
         // Outliers are blocked but STAY in window (for error/event detection)
         // =================================================================
-        EV << "\n=== INITIAL WINDOW PROCESSING (all " << n << " samples) ===\n";
-        EV << "Mean: T=" << mu[0] << " H=" << mu[1] << " L=" << mu[2] << " V=" << mu[3] << "\n";
+        EV_DETAIL << "\n=== INITIAL WINDOW PROCESSING (all " << n << " samples) ===\n";
+        EV_DETAIL << "Mean: T=" << mu[0] << " H=" << mu[1] << " L=" << mu[2] << " V=" << mu[3] << "\n";
         
         int detectedCount = 0;
         for (int i = 0; i < n; i++) {
             SensorMsg* msg = slidingWindow[i];
-            double md = calculateMahalanobis(X[i], mu, InvSigma);
-            bool actualOutlier = msg->isOutlier();
-            bool detectedAsOutlier = (md >= threshold);
-            int sourceId = msg->getSourceId();
-            
-            // Record detection metrics
-            metrics.recordDetection(actualOutlier, detectedAsOutlier);
-            
-            // Log result
-            EV << "  [" << i << "] Node" << sourceId
-               << " T=" << X[i][0] << " MD=" << md;
-            
-            if (actualOutlier && detectedAsOutlier) {
-                EV << " [TP]";
-            } else if (actualOutlier && !detectedAsOutlier) {
-                EV << " [FN-MISSED!]";
-            } else if (!actualOutlier && detectedAsOutlier) {
-                EV << " [FP]";
+            double md;
+            if (algorithm == ALG_MCD_MD) {
+                md = mcd.md[i];
             } else {
-                EV << " [TN]";
+                PROFILE_STAGE(profiler, STAGE_MAHALANOBIS);
+                md = calculateMahalanobis(X[i], mu, InvSigma);
+            }
+            bool detectedAsOutlier = (md >= threshold);
+            if (shadowReference) compareWithReference(msg, X[i], md, detectedAsOutlier);
+
+            // Record detection metrics (+ trace ring, debug log)
+            {
+                PROFILE_STAGE(profiler, STAGE_METRICS);
+                recordDecision(msg, md, detectedAsOutlier, "INITIAL");
             }
             
             if (detectedAsOutlier) {
-                EV << " -> BLOCKED";
-                totalOutliersDetected++;
+                PROFILE_STAGE(profiler, STAGE_SEND);
+                noteOutlier(msg);
                 detectedCount++;
                 // Sample stays in window (not deleted) for error/event classification
             } else {
-                EV << " -> FORWARDED";
-                send(msg->dup(), "out");  // Send copy, original stays in window
-                totalPacketsForwarded++;
-                energy.transmit(256, 30.0);
+                PROFILE_STAGE(profiler, STAGE_SEND);
+                forwardClean(msg);  // Send copy, original stays in window
             }
-            EV << "\n";
         }
         
-        EV << "=== INITIAL WINDOW DONE: " << detectedCount << "/" << n << " outliers blocked ===\n\n";
+        EV_DETAIL << "=== INITIAL WINDOW DONE: " << detectedCount << "/" << n << " outliers blocked ===\n\n";
         isInitialWindowProcessed = true;
         
     } else {
         // =================================================================
-        // SLIDING MODE: Only calculate MD for the NEWEST sample
+        // SLIDING MODE: Only calculate MD for the NEWEST sample(s)
         // =================================================================
-        int newestIdx = n - 1;
-        SensorMsg* newestMsg = slidingWindow[newestIdx];
-        
-        double md = calculateMahalanobis(X[newestIdx], mu, InvSigma);
-        bool actualOutlier = newestMsg->isOutlier();
-        bool detectedAsOutlier = (md >= threshold);
-        int sourceId = newestMsg->getSourceId();
-        
-        // Record detection metrics
-        metrics.recordDetection(actualOutlier, detectedAsOutlier);
-        
-        // Log detection result
-        EV << "[SLIDING] Node" << sourceId
-           << " T=" << X[newestIdx][0]
-           << " MD=" << md;
-        
-        if (actualOutlier && detectedAsOutlier) {
-            EV << " [TP]";
-        } else if (actualOutlier && !detectedAsOutlier) {
-            EV << " [FN-MISSED!]";
-        } else if (!actualOutlier && detectedAsOutlier) {
-            EV << " [FP]";
-        } else {
-            EV << " [TN]";
+        // Round batching scores the whole round against the same model
+        for (int newestIdx = n - newSamples; newestIdx < n; newestIdx++) {
+            SensorMsg* newestMsg = slidingWindow[newestIdx];
+
+            double md;
+            if (algorithm == ALG_MCD_MD) {
+                md = mcd.md[newestIdx];
+            } else {
+                PROFILE_STAGE(profiler, STAGE_MAHALANOBIS);
+                md = calculateMahalanobis(X[newestIdx], mu, InvSigma);
+            }
+            bool actualOutlier = newestMsg->isOutlier();
+            bool detectedAsOutlier = (md >= threshold);
+            if (shadowReference) compareWithReference(newestMsg, X[newestIdx], md, detectedAsOutlier);
+
+            // Multi-cluster: score the same sample against the network-wide model.
+            // The model not used for the decision is tracked in altMetrics.
+            if (hasGlobalModel) {
+                PROFILE_STAGE(profiler, STAGE_MAHALANOBIS);
+                double globalMd = calculateMahalanobis(X[newestIdx], globalMean, globalInvCov);
+                bool globalDetected = (globalMd >= threshold);
+                if (useGlobalModel) {
+                    altMetrics.recordDetection(actualOutlier, detectedAsOutlier);
+                    md = globalMd;
+                    detectedAsOutlier = globalDetected;
+                } else {
+                    altMetrics.recordDetection(actualOutlier, globalDetected);
+                }
+            }
+
+            // Record detection metrics (+ trace ring, debug log)
+            {
+                PROFILE_STAGE(profiler, STAGE_METRICS);
+                recordDecision(newestMsg, md, detectedAsOutlier, n < windowSize ? "WARMSTART" : "SLIDING");
+            }
+
+            if (detectedAsOutlier) {
+                PROFILE_STAGE(profiler, STAGE_SEND);
+                noteOutlier(newestMsg);
+                // Sample stays in window for error/event classification
+            } else {
+                PROFILE_STAGE(profiler, STAGE_SEND);
+                forwardClean(newestMsg);  // Send copy, original stays in window
+            }
         }
-        
-        if (detectedAsOutlier) {
-            EV << " -> BLOCKED\n";
-            totalOutliersDetected++;
-            // Sample stays in window for error/event classification
+    }
+}
+
+// =============================================================================
+// LOF: Local Outlier Factor over the sliding window (IncrementalLof.h)
+// Density-based, so non-elliptical clusters (e.g. light switching between
+// levels) are not flagged as a whole. The index follows the window: each
+// evicted sample is removed and each new one inserted, and only the
+// neighbourhoods they touch are updated. Scoring mirrors ODA-MD: all
+// samples of the initial window, then the newest sample(s).
+// =============================================================================
+void ClusterHead::runLOF(int newSamples)
+{
+    int n = slidingWindow.size();
+    if (n < windowSize) return;
+
+    {
+        PROFILE_STAGE(profiler, STAGE_LOF_UPDATE);
+        while (!lofSlots.empty() && lofSlots.front().first != slidingWindow.front()->getId()) {
+            lofIndex.remove(lofSlots.front().second);
+            lofSlots.pop_front();
+        }
+        for (int i = lofSlots.size(); i < n; i++) {
+            SensorMsg *m = slidingWindow[i];
+            std::vector<double> x = {
+                m->getTemperature(), m->getHumidity(), m->getLight(), m->getVoltage()
+            };
+            lofSlots.push_back(std::make_pair(m->getId(), lofIndex.insert(x)));
+        }
+    }
+
+    int first = isInitialWindowProcessed ? n - newSamples : 0;
+    const char *tag = isInitialWindowProcessed ? "LOF" : "INITIAL";
+    for (int i = first; i < n; i++) {
+        SensorMsg *msg = slidingWindow[i];
+        double score = lofIndex.getLof(lofSlots[i].second);
+        bool detectedAsOutlier = (score >= threshold);
+        {
+            PROFILE_STAGE(profiler, STAGE_METRICS);
+            recordDecision(msg, score, detectedAsOutlier, tag);
+        }
+        {
+            PROFILE_STAGE(profiler, STAGE_SEND);
+            if (detectedAsOutlier) noteOutlier(msg);
+            else forwardClean(msg);  // Send copy, original stays in window
+        }
+    }
+    isInitialWindowProcessed = true;
+}
+
+// =============================================================================
+// MCD-MD: robust window model (McdEstimator.h)
+// Mean and covariance of the h most central window samples instead of all
+// of them, so outliers still in the window do not mask the next ones. The
+// subset is kept by message id and carried to the next window (evicted
+// members replaced by the newest samples), so a window update costs only
+// mcdCSteps C-steps; the first window, and the one after a singular fit,
+// starts from the median and runs mcdInitialCSteps.
+// =============================================================================
+bool ClusterHead::fitMcdModel(const DetectorMath::Matrix& X, McdEstimator::Model& model)
+{
+    int n = X.size();
+    int h = McdEstimator::subsetSize(n, mcdSubsetFraction);
+    std::vector<int> H;
+    int steps = mcdCSteps;
+
+    if (!mcdSubset.empty()) {
+        std::set<msgid_t> kept(mcdSubset.begin(), mcdSubset.end());
+        std::vector<bool> inH(n, false);
+        for (int i = 0; i < n; i++) {
+            if (kept.count(slidingWindow[i]->getId())) {
+                H.push_back(i);
+                inH[i] = true;
+            }
+        }
+        for (int i = n - 1; i >= 0 && (int)H.size() < h; i--) {
+            if (!inH[i]) H.push_back(i);
+        }
+        if ((int)H.size() > h) H.erase(H.begin(), H.end() - h);  // Window shrank: keep the newest
+    } else {
+        H = McdEstimator::initialSubset(kernels, X, h);
+        steps = mcdInitialCSteps;
+    }
+
+    std::vector<int> start = H;
+    model = McdEstimator::concentrate(kernels, X, H, steps);
+    mcdFits++;
+    mcdStepsRun += model.stepsRun;
+    mcdSubset.clear();
+    if (model.ok) {
+        for (int i : H) mcdSubset.push_back(slidingWindow[i]->getId());
+    }
+
+    // Double shadow from the same starting subset
+    if (shadowReference) {
+        UncountedOps uncounted;
+        McdEstimator::Model ref = McdEstimator::concentrate(reference, X, start, steps);
+        refMean = ref.mean;
+        refInvCov = ref.invCov;
+        refValid = ref.ok;
+    }
+    return model.ok;
+}
+
+// =============================================================================
+// EWMA-MD: exponentially weighted mean and covariance (EwmaModel.h)
+// Same MD threshold test as ODA-MD, but the model is O(d^2) state updated
+// per sample (Sherman-Morrison) instead of a window of windowSize messages.
+// The first windowSize samples only warm the model up and are forwarded.
+// =============================================================================
+void ClusterHead::runEWMAMD(SensorMsg *msg)
+{
+    std::vector<double> x = {
+        msg->getTemperature(), msg->getHumidity(), msg->getLight(), msg->getVoltage()
+    };
+
+    double md;
+    bool scored;
+    {
+        PROFILE_STAGE(profiler, STAGE_MAHALANOBIS);
+        scored = ewma.update(kernels, x, md);
+    }
+    if (adaptiveSampling) windowCov = ewma.getCovariance();
+
+    double refMd = 0.0;
+    bool refScored = false;
+    if (shadowReference) {
+        UncountedOps uncounted;
+        refScored = refEwma.update(reference, x, refMd);
+    }
+
+    if (scored && shadowReference) noteReferenceDecision(msg, md, md >= threshold, refMd, refScored);
+    releaseDecision(msg, scored, md, scored ? "EWMA" : "WARMUP");
+}
+
+// Unscored samples (model warming up or singular) are forwarded as clean
+void ClusterHead::releaseDecision(SensorMsg *msg, bool scored, double md, const char *tag)
+{
+    bool detectedAsOutlier = scored && (md >= threshold);
+    {
+        PROFILE_STAGE(profiler, STAGE_METRICS);
+        recordDecision(msg, md, detectedAsOutlier, tag);
+    }
+    {
+        PROFILE_STAGE(profiler, STAGE_SEND);
+        if (detectedAsOutlier) noteOutlier(msg);
+        else forwardClean(msg);
+    }
+    delete msg;
+}
+
+// =============================================================================
+// PER-SOURCE MODELS (perSourceModels = true)
+// One noisy mote only distorts its own model. ODA-MD: the source's last
+// windowSize readings (SourceArena), scored from the windowSize-th reading
+// on; EWMA-MD: one EwmaModel per source. State is indexed by dense slot,
+// no per-source heap objects.
+// =============================================================================
+void ClusterHead::runPerSource(SensorMsg *msg)
+{
+    int slot = sourceArena.slotFor(msg->getSourceId());
+    std::vector<double> x = {
+        msg->getTemperature(), msg->getHumidity(), msg->getLight(), msg->getVoltage()
+    };
+
+    double md = 0.0;
+    bool scored = false;
+
+    if (algorithm == ALG_EWMA_MD) {
+        if (slot >= (int)sourceEwma.size()) {
+            sourceEwma.push_back(ewma);
+            if (shadowReference) sourceRefEwma.push_back(refEwma);
+        }
+        {
+            PROFILE_STAGE(profiler, STAGE_MAHALANOBIS);
+            scored = sourceEwma[slot].update(kernels, x, md);
+        }
+        if (shadowReference) {
+            double refMd = 0.0;
+            bool refScored;
+            {
+                UncountedOps uncounted;
+                refScored = sourceRefEwma[slot].update(reference, x, refMd);
+            }
+            if (scored) noteReferenceDecision(msg, md, md >= threshold, refMd, refScored);
+        }
+        releaseDecision(msg, scored, md, scored ? "SOURCE-EWMA" : "WARMUP");
+        return;
+    }
+
+    sourceArena.push(slot, x);
+    const char *tag = "WARMUP";
+    int count = sourceArena.getCount(slot);
+    if (count >= windowSize || baseline.isLoaded()) {
+        {
+            PROFILE_STAGE(profiler, STAGE_WINDOW_TO_MATRIX);
+            sourceArena.window(slot, sourceX);
+        }
+        std::vector<double> mu;
+        DetectorMath::Matrix Sigma;
+        if (count < windowSize) {
+            // Warm start, as in runODAMD
+            PROFILE_STAGE(profiler, STAGE_COVARIANCE);
+            baseline.blend(sourceX, baselineWeight * (windowSize - count) / windowSize, mu, Sigma);
         } else {
-            EV << " -> FORWARDED\n";
-            send(newestMsg->dup(), "out");  // Send copy, original stays in window
-            totalPacketsForwarded++;
-            energy.transmit(256, 30.0);
+            {
+                PROFILE_STAGE(profiler, STAGE_MEAN);
+                mu = calculateMean(sourceX);
+            }
+            PROFILE_STAGE(profiler, STAGE_COVARIANCE);
+            Sigma = calculateCovariance(sourceX, mu);
+        }
+        DetectorMath::Matrix InvSigma(4, std::vector<double>(4));
+        {
+            PROFILE_STAGE(profiler, STAGE_INVERSION);
+            scored = invertMatrix4x4(Sigma, InvSigma);
+        }
+        tag = !scored ? "SINGULAR" : (count < windowSize) ? "SOURCE-WARM" : "SOURCE";
+        if (scored) {
+            PROFILE_STAGE(profiler, STAGE_MAHALANOBIS);
+            md = calculateMahalanobis(x, mu, InvSigma);
+        }
+        if (shadowReference) {
+            if (count < windowSize) setReferenceModel(mu, Sigma);
+            else buildReferenceModel(sourceX);
+            if (scored) compareWithReference(msg, x, md, md >= threshold);
         }
     }
+    releaseDecision(msg, scored, md, tag);
 }
 
 // =============================================================================
@@ -310,27 +1289,37 @@ void ClusterHead::runOD()
 
     // Convert buffer to data matrix
     std::vector<std::vector<double>> X(n, std::vector<double>(4));
-    for (int i = 0; i < n; i++) {
-        X[i][0] = slidingWindow[i]->getTemperature();
-        X[i][1] = slidingWindow[i]->getHumidity();
-        X[i][2] = slidingWindow[i]->getLight();
-        X[i][3] = slidingWindow[i]->getVoltage();
-        
-        // Track sensor readings for trust calculation
-        int sensorId = slidingWindow[i]->getSourceId();
-        sensorTotalCount[sensorId]++;
+    {
+        PROFILE_STAGE(profiler, STAGE_WINDOW_TO_MATRIX);
+        for (int i = 0; i < n; i++) {
+            X[i][0] = slidingWindow[i]->getTemperature();
+            X[i][1] = slidingWindow[i]->getHumidity();
+            X[i][2] = slidingWindow[i]->getLight();
+            X[i][3] = slidingWindow[i]->getVoltage();
+
+            // Track sensor readings for trust calculation
+            int sensorId = slidingWindow[i]->getSourceId();
+            sensorTotalCount[sensorId]++;
+        }
     }
 
-    energy.process(200);  // More computation than ODA-MD due to clustering
-
     // === STEP 1: Fixed-Width Clustering ===
-    runOD_Clustering(X);
+    {
+        PROFILE_STAGE(profiler, STAGE_OD_CLUSTERING);
+        runOD_Clustering(X);
+    }
     
     // === STEP 2: Outlier Detection (Inter-cluster distance) ===
-    runOD_Detection();
+    {
+        PROFILE_STAGE(profiler, STAGE_OD_DETECTION);
+        runOD_Detection();
+    }
     
     // === STEP 3 & 4: Classification and Processing ===
-    runOD_Classification(X);
+    {
+        PROFILE_STAGE(profiler, STAGE_OD_CLASSIFICATION);
+        runOD_Classification(X);
+    }
     
     // OD uses batch processing - clear window after processing
     for (auto msg : slidingWindow) {
@@ -370,10 +1359,7 @@ void ClusterHead::runOD_Clustering(const std::vector<std::vector<double>>& X)
                 cluster.members.push_back(i);
                 
                 // Update cluster center (incremental mean)
-                int m = cluster.members.size();
-                for (int j = 0; j < 4; j++) {
-                    cluster.center[j] = ((m - 1) * cluster.center[j] + X[i][j]) / m;
-                }
+                kernels.updateCentroid(cluster.center, X[i], cluster.members.size());
                 assigned = true;
                 break;
             }
@@ -390,7 +1376,7 @@ void ClusterHead::runOD_Clustering(const std::vector<std::vector<double>>& X)
         }
     }
     
-    EV << "[OD] Created " << odClusters.size() << " clusters from " << X.size() << " points\n";
+    EV_DEBUG << "[OD] Created " << odClusters.size() << " clusters from " << X.size() << " points\n";
 }
 
 // -----------------------------------------------------------------------------
@@ -415,29 +1401,18 @@ void ClusterHead::runOD_Detection()
     energy.receive(128 * numClusters * (numClusters - 1));
     
     // Calculate inter-cluster distances
+    std::vector<std::vector<double>> centers;
+    for (const auto& cluster : odClusters) {
+        centers.push_back(cluster.center);
+    }
+    std::vector<double> avgDist = kernels.interClusterDistances(centers);
     for (int i = 0; i < numClusters; i++) {
-        double sumDist = 0;
-        for (int j = 0; j < numClusters; j++) {
-            if (i != j) {
-                sumDist += calculateEuclidean(odClusters[i].center, odClusters[j].center);
-            }
-        }
-        odClusters[i].avgInterClusterDist = sumDist / (numClusters - 1);
+        odClusters[i].avgInterClusterDist = avgDist[i];
     }
     
     // Calculate mean and std of distances
-    double sumDist = 0;
-    for (const auto& cluster : odClusters) {
-        sumDist += cluster.avgInterClusterDist;
-    }
-    double meanDist = sumDist / numClusters;
-    
-    double variance = 0;
-    for (const auto& cluster : odClusters) {
-        double diff = cluster.avgInterClusterDist - meanDist;
-        variance += diff * diff;
-    }
-    double stdDist = std::sqrt(variance / numClusters);
+    double meanDist, stdDist;
+    kernels.meanStd(avgDist, meanDist, stdDist);
     
     // Label outlier clusters (distance > mean + 1*std)
     double outlierThreshold = meanDist + stdDist;
@@ -450,7 +1425,7 @@ void ClusterHead::runOD_Detection()
         }
     }
     
-    EV << "[OD] Threshold=" << outlierThreshold << " (mean=" << meanDist 
+    EV_DEBUG << "[OD] Threshold=" << outlierThreshold << " (mean=" << meanDist 
        << " + std=" << stdDist << "), " << outlierClusterCount << " outlier clusters\n";
 }
 
@@ -496,24 +1471,23 @@ void ClusterHead::runOD_Classification(const std::vector<std::vector<double>>& X
         bool isEvent = (clusterSensors[c].size() >= 2);
         
         for (int idx : cluster.members) {
-            bool actualOutlier = slidingWindow[idx]->isOutlier();
             bool detectedAsOutlier = cluster.isOutlier;
             int sensorId = slidingWindow[idx]->getSourceId();
             
-            // Record metrics
-            metrics.recordDetection(actualOutlier, detectedAsOutlier);
+            // Record metrics (+ trace ring, debug log)
+            recordDecision(slidingWindow[idx], cluster.avgInterClusterDist, detectedAsOutlier, "OD");
             
             if (detectedAsOutlier) {
                 if (!isEvent) {
                     sensorErrorCount[sensorId]++;
                 }
                 
-                EV << " -> OD Outlier: Node " << sensorId 
+                EV_DEBUG << " -> OD Outlier: Node " << sensorId 
                    << " Cluster=" << c
                    << " Type=" << (isEvent ? "EVENT" : "ERROR") << "\n";
                 
                 toDelete[idx] = true;
-                totalOutliersDetected++;
+                noteOutlier(slidingWindow[idx]);
                 detectedCount++;
             } else {
                 toSend[idx] = true;
@@ -524,14 +1498,12 @@ void ClusterHead::runOD_Classification(const std::vector<std::vector<double>>& X
     // Third pass: actually send in order (deletion handled in runOD)
     for (int i = 0; i < bufferSize; i++) {
         if (toSend[i]) {
-            send(slidingWindow[i]->dup(), "out");  // Send copy for OD batch mode
-            totalPacketsForwarded++;
-            energy.transmit(256, 30.0);
+            forwardClean(slidingWindow[i]);  // Send copy for OD batch mode
         }
     }
     
     if (detectedCount > 0) {
-        EV << "[OD] Batch result: " << detectedCount << "/" << bufferSize 
+        EV_DEBUG << "[OD] Batch result: " << detectedCount << "/" << bufferSize 
            << " outliers detected.\n";
     }
 }
@@ -550,101 +1522,75 @@ double ClusterHead::getSensorTrust(int sensorId)
 }
 
 // --- MATH FUNCTIONS ---
+// Kernels live in DetectorMath.h, instantiated for the numericType parameter
 
 std::vector<double> ClusterHead::calculateMean(const std::vector<std::vector<double>>& data) {
-    int n = data.size();
-    std::vector<double> mean(4, 0.0);
-    for (const auto& row : data) {
-        for (int j = 0; j < 4; j++) mean[j] += row[j];
-    }
-    for (int j = 0; j < 4; j++) mean[j] /= n;
-    return mean;
+    return kernels.mean(data);
 }
 
 std::vector<std::vector<double>> ClusterHead::calculateCovariance(const std::vector<std::vector<double>>& data, const std::vector<double>& mean) {
-    int n = data.size();
-    std::vector<std::vector<double>> cov(4, std::vector<double>(4, 0.0));
-    for (const auto& row : data) {
-        for (int j = 0; j < 4; j++) {
-            for (int k = 0; k < 4; k++) {
-                cov[j][k] += (row[j] - mean[j]) * (row[k] - mean[k]);
-            }
-        }
-    }
-    for (int j = 0; j < 4; j++) {
-        for (int k = 0; k < 4; k++) {
-            cov[j][k] /= (n - 1);
-        }
-    }
-
-    // Regularization để tránh singular matrix
-    for (int j = 0; j < 4; j++) {
-        cov[j][j] += 0.001;
-    }
-
-    return cov;
+    return kernels.covariance(data, mean);
 }
 
 bool ClusterHead::invertMatrix4x4(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& inverse) {
-    int n = 4;
-    std::vector<std::vector<double>> aug = matrix;
-
-    for (int i = 0; i < n; i++)
-        for (int j = 0; j < n; j++)
-            inverse[i][j] = (i == j) ? 1.0 : 0.0;
+    return kernels.invert4x4(matrix, inverse);
+}
 
-    for (int i = 0; i < n; i++) {
-        int maxRow = i;
-        for (int k = i + 1; k < n; k++) {
-            if (std::abs(aug[k][i]) > std::abs(aug[maxRow][i]))
-                maxRow = k;
-        }
-        std::swap(aug[i], aug[maxRow]);
-        std::swap(inverse[i], inverse[maxRow]);
+double ClusterHead::calculateMahalanobis(const std::vector<double>& sample, const std::vector<double>& mean, const std::vector<std::vector<double>>& invCov) {
+    return kernels.mahalanobis(sample, mean, invCov);
+}
 
-        double pivot = aug[i][i];
-        if (std::abs(pivot) < 1e-9) return false;
+double ClusterHead::calculateEuclidean(const std::vector<double>& sample, const std::vector<double>& mean) {
+    return kernels.euclidean(sample, mean);
+}
 
-        for (int j = 0; j < n; j++) {
-            aug[i][j] /= pivot;
-            inverse[i][j] /= pivot;
-        }
+// =============================================================================
+// REDUCED-PRECISION ACCURACY (numericType = float / q16.16 / q8.24)
+// The same window is modelled in double; its MD and decision are compared
+// with the selected kernels. The shadow is simulation-side only, so its
+// operations are not charged to the CH.
+// =============================================================================
+void ClusterHead::buildReferenceModel(const DetectorMath::Matrix& X)
+{
+    UncountedOps uncounted;
 
-        for (int k = 0; k < n; k++) {
-            if (k != i) {
-                double factor = aug[k][i];
-                for (int j = 0; j < n; j++) {
-                    aug[k][j] -= factor * aug[i][j];
-                    inverse[k][j] -= factor * inverse[i][j];
-                }
-            }
-        }
-    }
-    return true;
+    refMean = reference.mean(X);
+    DetectorMath::Matrix cov = reference.covariance(X, refMean);
+    refInvCov.assign(4, std::vector<double>(4));
+    refValid = reference.invert4x4(cov, refInvCov);
 }
 
-double ClusterHead::calculateMahalanobis(const std::vector<double>& sample, const std::vector<double>& mean, const std::vector<std::vector<double>>& invCov) {
-    std::vector<double> diff(4);
-    for (int i = 0; i < 4; i++) diff[i] = sample[i] - mean[i];
+// Shadow of a model computed in double anyway (warm-start blend): only the inversion differs
+void ClusterHead::setReferenceModel(const std::vector<double>& mean, const DetectorMath::Matrix& cov)
+{
+    UncountedOps uncounted;
 
-    double mdSq = 0.0;
-    for (int i = 0; i < 4; i++) {
-        double temp = 0.0;
-        for (int j = 0; j < 4; j++) {
-            temp += diff[j] * invCov[j][i];
-        }
-        mdSq += temp * diff[i];
+    refMean = mean;
+    refInvCov.assign(4, std::vector<double>(4));
+    refValid = reference.invert4x4(cov, refInvCov);
+}
+
+void ClusterHead::compareWithReference(SensorMsg *msg, const std::vector<double>& x, double md, bool detected)
+{
+    double refMd = 0.0;
+    {
+        UncountedOps uncounted;
+        if (refValid) refMd = reference.mahalanobis(x, refMean, refInvCov);
     }
-    return (mdSq > 0) ? std::sqrt(mdSq) : 0.0;
+
+    noteReferenceDecision(msg, md, detected, refMd, refValid);
 }
 
-double ClusterHead::calculateEuclidean(const std::vector<double>& sample, const std::vector<double>& mean) {
-    double sumSq = 0.0;
-    for (int i = 0; i < 4; i++) {
-        double diff = sample[i] - mean[i];
-        sumSq += diff * diff;
+void ClusterHead::noteReferenceDecision(SensorMsg *msg, double md, bool detected, double refMd, bool refOk)
+{
+    bool refDetected = refOk && (refMd >= threshold);
+    mdError.collect(std::fabs(md - refMd));
+    if (detected != refDetected) {
+        decisionFlips++;
+        EV_DEBUG << "[" << kernels.name << "] Node" << msg->getSourceId()
+                 << " decision flip: MD=" << md << " vs double MD=" << refMd << "\n";
     }
-    return std::sqrt(sumSq);
+    refMetrics.recordDetection(msg->isOutlier(), refDetected);
 }
 
 // =============================================================================
@@ -656,9 +1602,28 @@ void ClusterHead::sendDataRequest()
 {
     requestId++;
     
-    EV << "[" << simTime() << "] CH sending request #" << requestId 
+    EV_DEBUG << "[" << simTime() << "] CH sending request #" << requestId 
        << " to " << numSensors << " sensors\n";
     
+    // Round-completion tracking: remember when this round started; forget
+    // rounds that are too old to ever complete (dead sensors)
+    if (numSensors > 0) {
+        pendingRounds[requestId] = PendingRound{simTime(), numSensors};
+        while (pendingRounds.size() > 64) {
+            pendingRounds.erase(pendingRounds.begin());
+            incompleteRounds++;
+        }
+    }
+
+    // Round batching: the previous round is closed by the new request at the latest
+    if (roundBatching) {
+        closeRound(false);
+        openRoundId = requestId;
+        if (roundDeadline > 0) {
+            scheduleAt(simTime() + roundDeadline, roundDeadlineTimer);
+        }
+    }
+
     // Send request to all sensors in the cluster
     for (int i = 0; i < numSensors; i++) {
         RequestMsg *req = new RequestMsg("DataRequest");
@@ -671,10 +1636,591 @@ void ClusterHead::sendDataRequest()
     }
 }
 
+// =============================================================================
+// ADAPTIVE SAMPLING
+// Checked once per round. Unstable (an outlier, or max MD near the
+// threshold): divide the interval at once. Stable (low max MD and a
+// covariance that barely moved) for stableRounds rounds: multiply it.
+// Anything in between keeps the current interval.
+// =============================================================================
+void ClusterHead::adaptRequestInterval()
+{
+    double covChange = 0.0;
+    if (!windowCov.empty() && !adaptCov.empty()) {
+        double diffSq = 0.0, normSq = 0.0;
+        for (int j = 0; j < 4; j++) {
+            for (int k = 0; k < 4; k++) {
+                double d = windowCov[j][k] - adaptCov[j][k];
+                diffSq += d * d;
+                normSq += adaptCov[j][k] * adaptCov[j][k];
+            }
+        }
+        covChange = (normSq > 0) ? std::sqrt(diffSq / normSq) : 0.0;
+    }
+
+    // OD scores are distances, not MDs: only its outliers count
+    bool scoresApply = (algorithm != ALG_OD);
+    bool unstable = adaptOutliers > 0
+        || (scoresApply && adaptMaxScore >= unstableScoreFraction * threshold);
+    bool stable = !unstable && !windowCov.empty()
+        && (!scoresApply || adaptMaxScore < stableScoreFraction * threshold)
+        && covChange <= covChangeTolerance;
+
+    double oldInterval = requestInterval;
+    if (unstable) {
+        stableCount = 0;
+        requestInterval = std::max(minRequestInterval, requestInterval / adaptFactor);
+    } else if (stable) {
+        if (++stableCount >= stableRounds) {
+            stableCount = 0;
+            requestInterval = std::min(maxRequestInterval, requestInterval * adaptFactor);
+        }
+    }
+
+    if (requestInterval != oldInterval) {
+        emit(requestIntervalSignal, requestInterval);
+        EV_DEBUG << "[" << simTime() << "] requestInterval " << oldInterval << "s -> "
+                 << requestInterval << "s (maxMD=" << adaptMaxScore << ", outliers="
+                 << adaptOutliers << ", covChange=" << covChange << ")\n";
+    }
+
+    adaptMaxScore = 0;
+    adaptOutliers = 0;
+    adaptCov = windowCov;
+}
+
+// =============================================================================
+// OUTPUT PATH TO SINK
+// Raw mode: every clean sample is forwarded as its own SensorMsg.
+// Aggregation mode: clean samples are folded into the interval statistics and
+// one SummaryMsg per aggregationInterval is sent instead.
+// =============================================================================
+void ClusterHead::forwardClean(SensorMsg *msg)
+{
+    totalPacketsForwarded++;
+
+    if (!aggregation) {
+        sendToSink(msg->dup());
+        energy.transmit(256, 30.0);
+        return;
+    }
+
+    double x[SufficientStats::DIM] = {
+        msg->getTemperature(), msg->getHumidity(), msg->getLight(), msg->getVoltage()
+    };
+    intervalStats.add(x);
+    energy.aggregate(256);  // Fold one 256-bit reading into the summary (E_DA)
+}
+
+void ClusterHead::noteOutlier(SensorMsg *msg)
+{
+    totalOutliersDetected++;
+    if (aggregation) {
+        intervalOutliers.push_back(msg->getSourceId());
+    }
+}
+
+void ClusterHead::sendSummary()
+{
+    if (intervalStats.getCount() == 0 && intervalOutliers.empty()) {
+        intervalStart = simTime();
+        return;
+    }
+
+    const int D = SufficientStats::DIM;
+    SummaryMsg *summary = new SummaryMsg("Summary");
+    summary->setChId(chMoteId);
+    summary->setIntervalStart(intervalStart);
+    summary->setCount(intervalStats.getCount());
+    for (int j = 0; j < D; j++) {
+        summary->setMean(j, intervalStats.getMean(j));
+        summary->setMinValue(j, intervalStats.getMin(j));
+        summary->setMaxValue(j, intervalStats.getMax(j));
+        for (int k = 0; k < D; k++) {
+            summary->setCovariance(j * D + k, intervalStats.getCovariance(j, k));
+        }
+    }
+    summary->setOutlierSourcesArraySize(intervalOutliers.size());
+    for (size_t i = 0; i < intervalOutliers.size(); i++) {
+        summary->setOutlierSources(i, intervalOutliers[i]);
+    }
+
+    // Payload: header 64 + count 32 + mean 4x32 + covariance (symmetric) 10x32
+    //          + min/max 8x32 + 16 bits per outlier source
+    int bits = 64 + 32 + 4 * 32 + 10 * 32 + 8 * 32 + 16 * (int)intervalOutliers.size();
+    energy.transmit(bits, 30.0);
+    send(summary, "out");
+    totalSummariesSent++;
+
+    EV << "[" << simTime() << "] CH summary #" << totalSummariesSent
+       << ": " << intervalStats.getCount() << " clean samples, "
+       << intervalOutliers.size() << " outliers\n";
+
+    intervalStats.reset();
+    intervalOutliers.clear();
+    intervalStart = simTime();
+}
+
+// =============================================================================
+// MULTI-CLUSTER MODEL EXCHANGE
+// Each CH reports the sufficient statistics (n, mean, scatter) of its current
+// window; the Sink merges all CH models into a network-wide model and sends
+// it back, so detection can be compared against local vs global models.
+// =============================================================================
+void ClusterHead::sendModelReport()
+{
+    const int D = SufficientStats::DIM;
+    ModelMsg *report = new ModelMsg("ModelReport");
+    report->setChId(chMoteId);
+
+    if (algorithm == ALG_EWMA_MD) {
+        // EWMA model as a window of its effective length
+        if (!ewma.isWarm()) {
+            delete report;
+            return;
+        }
+        int n = (int)std::lround(ewma.getEffectiveCount());
+        std::vector<double> mean = ewma.getMean();
+        DetectorMath::Matrix cov = ewma.getDataCovariance();  // handleGlobalModel adds the diagonal term
+        report->setCount(n);
+        for (int j = 0; j < D; j++) {
+            report->setMean(j, mean[j]);
+            for (int k = 0; k < D; k++) {
+                report->setScatter(j * D + k, cov[j][k] * (n - 1));
+            }
+        }
+    } else {
+        if (slidingWindow.size() < 2) {
+            delete report;
+            return;
+        }
+        SufficientStats local;
+        for (SensorMsg *m : slidingWindow) {
+            double x[SufficientStats::DIM] = {
+                m->getTemperature(), m->getHumidity(), m->getLight(), m->getVoltage()
+            };
+            local.add(x);
+        }
+        report->setCount(local.getCount());
+        for (int j = 0; j < D; j++) {
+            report->setMean(j, local.getMean(j));
+            for (int k = 0; k < D; k++) {
+                report->setScatter(j * D + k, local.getScatter(j, k));
+            }
+        }
+    }
+
+    // Payload: header 64 + count 32 + mean 4x32 + scatter (symmetric) 10x32
+    energy.transmit(64 + 32 + 4 * 32 + 10 * 32, 30.0);
+    send(report, "out");
+}
+
+void ClusterHead::handleGlobalModel(ModelMsg *model)
+{
+    energy.receive(64 + 32 + 4 * 32 + 10 * 32);
+
+    int n = model->getCount();
+    if (n < 2) return;
+
+    const int D = SufficientStats::DIM;
+    std::vector<double> mean(D);
+    std::vector<std::vector<double>> cov(D, std::vector<double>(D));
+    for (int j = 0; j < D; j++) {
+        mean[j] = model->getMean(j);
+        for (int k = 0; k < D; k++) {
+            cov[j][k] = model->getScatter(j * D + k) / (n - 1);
+        }
+        cov[j][j] += 0.001;  // Same regularization as calculateCovariance
+    }
+
+    std::vector<std::vector<double>> inv(D, std::vector<double>(D));
+    bool invertible = invertMatrix4x4(cov, inv);
+    chargeKernelOps();  // The failed inversion was work too
+    if (!invertible) {
+        EV << "Warning: Singular global model, keeping previous one\n";
+        return;
+    }
+
+    globalMean = mean;
+    globalInvCov = inv;
+    hasGlobalModel = true;
+}
+
+// =============================================================================
+// PER-SAMPLE DECISION RECORD
+// Hot path: metrics + a struct copy into the trace ring. The text line is
+// EV_DEBUG, so it is compiled out below COMPILETIME_LOGLEVEL (release builds)
+// =============================================================================
+void ClusterHead::recordDecision(SensorMsg *msg, double score, bool detectedAsOutlier, const char *tag)
+{
+    bool actualOutlier = msg->isOutlier();
+    metrics.recordDetection(actualOutlier, detectedAsOutlier);
+    if (firstDecisionTime < SIMTIME_ZERO && strcmp(tag, "WARMUP") != 0 && strcmp(tag, "SINGULAR") != 0) {
+        firstDecisionTime = simTime();  // First sample actually scored
+    }
+    if (adaptiveSampling) {
+        adaptMaxScore = std::max(adaptMaxScore, score);
+        if (detectedAsOutlier) adaptOutliers++;
+    }
+    trace.push(simTime().dbl(), msg->getSourceId(), score, detectedAsOutlier, actualOutlier);
+
+    noteDecision({msg->getSourceId(), msg->getSeqNo(), msg->getSenseTime(), score, detectedAsOutlier});
+
+    EV_DEBUG << "[" << tag << "] Node" << msg->getSourceId()
+             << " T=" << msg->getTemperature() << " MD=" << score
+             << " " << decisionLabel(actualOutlier, detectedAsOutlier)
+             << (detectedAsOutlier ? " -> BLOCKED\n" : " -> FORWARDED\n");
+}
+
+// "_cluster<index>" when this CH is one of several clusters inside a
+// compound module, so their default output files do not collide
+std::string ClusterHead::clusterSuffix() const
+{
+    if (getParentModule() == getSystemModule()) return "";
+    return "_cluster" + std::to_string(getParentModule()->getIndex());
+}
+
+void ClusterHead::dumpTrace()
+{
+    if (!trace.isEnabled() || traceDumped) return;
+    traceDumped = true;
+    if (!trace.dump(traceFile)) {
+        EV_WARN << "Could not write trace file " << traceFile << "\n";
+    }
+}
+
+// =============================================================================
+// CHECKPOINT / RESTORE (Checkpoint.h)
+// At checkpointAt the CH writes its state to <checkpointDir>/<module path>.ckpt
+// and has every connected SensorNode save itself at the same instant. A run
+// with restoreDir continues from that state at the checkpoint time: timers
+// fire at their saved times and the window, models, counters and metrics
+// carry on, under the parameters of the new run (threshold or algorithm
+// branches off one warmed-up run). The Sink, latency histograms, profiler
+// and decision trace ring are not saved and start over; the LOF index is
+// rebuilt from the window.
+// =============================================================================
+void ClusterHead::writeCheckpoint()
+{
+    // Outputs of a sample in service are held messages: wait for the end of
+    // the service (the timer's priority puts it after serviceTimer)
+    if (serviceTimer->isScheduled()) {
+        scheduleAt(serviceTimer->getArrivalTime(), checkpointTimer);
+        return;
+    }
+
+    makeOutputDirectory(checkpointDir);
+    std::string filename = checkpointPath(checkpointDir, this);
+    CheckpointWriter out;
+    if (!out.open(filename, "ClusterHead", simTime().raw(), SimTime::getScaleExp()))
+        throw cRuntimeError("Cannot write checkpoint '%s'", filename.c_str());
+
+    // Window and open round (arrival time = the queueing timestamp)
+    std::vector<ArrivalRecord> samples;
+    for (SensorMsg *m : slidingWindow) samples.push_back(sampleRecord(m, m->getTimestamp()));
+    out.putVector(samples);
+    samples.clear();
+    for (SensorMsg *m : roundBatch) samples.push_back(sampleRecord(m, m->getTimestamp()));
+    out.putVector(samples);
+    out.put(openRoundId);
+    out.put(roundResponses);
+    out.put(isInitialWindowProcessed);
+
+    out.put(timerTime(logTimer));
+    out.put(timerTime(requestTimer));
+    out.put(timerTime(aggregationTimer));
+    out.put(timerTime(modelReportTimer));
+    out.put(timerTime(roundDeadlineTimer));
+
+    // Counters
+    out.put(totalPacketsReceived);
+    out.put(totalOutliersDetected);
+    out.put(totalPacketsForwarded);
+    out.put(batchesReceived);
+    out.putMap(decoders);
+    out.put(encodedReceived);
+    out.put(encodedBits);
+    out.put(decodeErrors);
+    out.put(eventsHandled);
+    out.put(requestId);
+    out.put((uint64_t)pendingRounds.size());
+    for (const auto& round : pendingRounds) {
+        out.put(round.first);
+        out.put(round.second.sentAt.raw());
+        out.put(round.second.outstanding);
+    }
+    out.put(incompleteRounds);
+    out.put(totalOps);
+    out.put(totalCycles);
+    out.put(busyTime.raw());
+    out.put(droppedPackets);
+    out.put(droppedOutliers);
+    out.put(roundsProcessed);
+    out.put(roundSamples);
+    out.put(roundsClosedIncomplete);
+    out.put(lateResponses);
+
+    // Adaptive sampling
+    out.put(requestInterval);
+    out.put(stableCount);
+    out.put(adaptMaxScore);
+    out.put(adaptOutliers);
+    out.putVectors(windowCov);
+    out.putVectors(adaptCov);
+    out.put(requestTimeTotal);
+
+    // Aggregation interval and the global model
+    out.put(intervalStats);
+    out.putVector(intervalOutliers);
+    out.put(intervalStart.raw());
+    out.put(totalSummariesSent);
+    out.put(hasGlobalModel);
+    out.putVector(globalMean);
+    out.putVectors(globalInvCov);
+
+    // Detector models (MCD subset by window position)
+    out.put(ewma);
+    out.put(refEwma);
+    sourceArena.save(out);
+    out.putVector(sourceEwma);
+    out.putVector(sourceRefEwma);
+    std::set<msgid_t> subset(mcdSubset.begin(), mcdSubset.end());
+    std::vector<int32_t> subsetPositions;
+    for (size_t i = 0; i < slidingWindow.size(); i++) {
+        if (subset.count(slidingWindow[i]->getId())) subsetPositions.push_back(i);
+    }
+    out.putVector(subsetPositions);
+    out.put(mcdFits);
+    out.put(mcdStepsRun);
+    out.putMap(sensorErrorCount);
+    out.putMap(sensorTotalCount);
+
+    metrics.save(out);
+    altMetrics.save(out);
+    refMetrics.save(out);
+    out.put(decisionFlips);
+    out.put(fixedSaturations);
+    out.put(energy);
+
+    if (!out.close())
+        throw cRuntimeError("Cannot write checkpoint '%s'", filename.c_str());
+
+    int sensors = 0;
+    for (int i = 0; i < numSensors; i++) {
+        SensorNode *sensor = dynamic_cast<SensorNode *>(gate("toSensor", i)->getPathEndGate()->getOwnerModule());
+        if (sensor == nullptr) continue;
+        sensor->saveCheckpoint(checkpointDir);
+        sensors++;
+    }
+    EV << "[" << simTime() << "] Checkpoint written: " << filename
+       << " (+ " << sensors << " sensors)\n";
+}
+
+simtime_t ClusterHead::restoreCheckpoint(const std::string& filename)
+{
+    CheckpointReader in;
+    if (!in.open(filename, "ClusterHead"))
+        throw cRuntimeError("Cannot restore '%s': missing, or not a ClusterHead checkpoint of this version",
+                            filename.c_str());
+    if (in.getScaleExp() != SimTime::getScaleExp())
+        throw cRuntimeError("Checkpoint '%s' uses simtime scale exponent %d, this run %d",
+                            filename.c_str(), in.getScaleExp(), SimTime::getScaleExp());
+    simtime_t at = SimTime::fromRaw(in.getTime());
+
+    // Window (a smaller windowSize keeps the newest samples) and open round
+    std::vector<ArrivalRecord> samples;
+    in.getVector(samples);
+    int dropped = std::max(0, (int)samples.size() - windowSize);
+    for (size_t i = dropped; i < samples.size(); i++) {
+        slidingWindow.push_back(sampleFromRecord(samples[i]));
+    }
+    in.getVector(samples);
+    int savedRoundId = -1, savedResponses = 0;
+    in.get(savedRoundId);
+    in.get(savedResponses);
+    if (roundBatching) {
+        for (const ArrivalRecord& r : samples) roundBatch.push_back(sampleFromRecord(r));
+        openRoundId = savedRoundId;
+        roundResponses = savedResponses;
+    }
+    in.get(isInitialWindowProcessed);
+    if (baseline.isLoaded()) isInitialWindowProcessed = true;
+
+    // Timers resume at their saved times; ones the checkpointed run did not
+    // have start one interval after the checkpoint
+    int64_t logAt = -1, requestAt = -1, aggregationAt = -1, modelReportAt = -1, deadlineAt = -1;
+    in.get(logAt);
+    in.get(requestAt);
+    in.get(aggregationAt);
+    in.get(modelReportAt);
+    in.get(deadlineAt);
+    cancelEvent(logTimer);
+    scheduleAt(logAt >= 0 ? SimTime::fromRaw(logAt) : at + logInterval, logTimer);
+    cancelEvent(requestTimer);
+    scheduleAt(requestAt >= 0 ? SimTime::fromRaw(requestAt) : at + requestInterval, requestTimer);
+    if (aggregationTimer != nullptr) {
+        cancelEvent(aggregationTimer);
+        scheduleAt(aggregationAt >= 0 ? SimTime::fromRaw(aggregationAt) : at + aggregationInterval, aggregationTimer);
+    }
+    if (modelReportTimer != nullptr) {
+        cancelEvent(modelReportTimer);
+        scheduleAt(modelReportAt >= 0 ? SimTime::fromRaw(modelReportAt) : at + modelReportInterval, modelReportTimer);
+    }
+    if (roundBatching && deadlineAt >= 0) {
+        scheduleAt(SimTime::fromRaw(deadlineAt), roundDeadlineTimer);
+    }
+
+    // Counters
+    in.get(totalPacketsReceived);
+    in.get(totalOutliersDetected);
+    in.get(totalPacketsForwarded);
+    in.get(batchesReceived);
+    in.getMap(decoders);
+    in.get(encodedReceived);
+    in.get(encodedBits);
+    in.get(decodeErrors);
+    in.get(eventsHandled);
+    in.get(requestId);
+    uint64_t rounds = 0;
+    in.get(rounds);
+    for (uint64_t i = 0; i < rounds && in.good(); i++) {
+        int id = 0, outstanding = 0;
+        int64_t sentAt = 0;
+        in.get(id);
+        in.get(sentAt);
+        in.get(outstanding);
+        pendingRounds[id] = PendingRound{SimTime::fromRaw(sentAt), outstanding};
+    }
+    in.get(incompleteRounds);
+    in.get(totalOps);
+    in.get(totalCycles);
+    int64_t busy = 0;
+    in.get(busy);
+    busyTime = SimTime::fromRaw(busy);
+    in.get(droppedPackets);
+    in.get(droppedOutliers);
+    in.get(roundsProcessed);
+    in.get(roundSamples);
+    in.get(roundsClosedIncomplete);
+    in.get(lateResponses);
+
+    // Adaptive sampling (the interval only if this run adapts it too)
+    double savedInterval = requestInterval;
+    in.get(savedInterval);
+    if (adaptiveSampling) {
+        requestInterval = std::min(std::max(savedInterval, minRequestInterval), maxRequestInterval);
+        emit(requestIntervalSignal, requestInterval);
+    }
+    in.get(stableCount);
+    in.get(adaptMaxScore);
+    in.get(adaptOutliers);
+    in.getVectors(windowCov);
+    in.getVectors(adaptCov);
+    in.get(requestTimeTotal);
+
+    // Aggregation interval (only if it was running) and the global model
+    SufficientStats savedStats;
+    std::vector<int> savedOutliers;
+    int64_t savedStart = 0;
+    in.get(savedStats);
+    in.getVector(savedOutliers);
+    in.get(savedStart);
+    if (aggregationAt >= 0) {
+        intervalStats = savedStats;
+        intervalOutliers.swap(savedOutliers);
+        intervalStart = SimTime::fromRaw(savedStart);
+    } else {
+        intervalStart = at;
+    }
+    in.get(totalSummariesSent);
+    in.get(hasGlobalModel);
+    in.getVector(globalMean);
+    in.getVectors(globalInvCov);
+
+    // Detector models: learned state only, parameters of this run. Per-source
+    // models need the same layout (window size, EWMA), else start empty.
+    EwmaModel savedEwma, savedRefEwma;
+    std::vector<EwmaModel> savedSourceEwma, savedSourceRefEwma;
+    in.get(savedEwma);
+    in.get(savedRefEwma);
+    bool arenaRestored = sourceArena.load(in);
+    in.getVector(savedSourceEwma);
+    in.getVector(savedSourceRefEwma);
+    if (perSourceModels && algorithm == ALG_EWMA_MD && arenaRestored
+            && (int)savedSourceEwma.size() == sourceArena.getNumSlots()) {
+        sourceEwma.assign(savedSourceEwma.size(), ewma);  // Still the configured template
+        for (size_t i = 0; i < savedSourceEwma.size(); i++) sourceEwma[i].resume(savedSourceEwma[i]);
+        if (shadowReference) {
+            sourceRefEwma.assign(savedSourceEwma.size(), refEwma);
+            for (size_t i = 0; i < savedSourceRefEwma.size() && i < sourceRefEwma.size(); i++)
+                sourceRefEwma[i].resume(savedSourceRefEwma[i]);
+        }
+    } else if (perSourceModels && (algorithm == ALG_EWMA_MD || !arenaRestored)) {
+        sourceArena.configure(algorithm == ALG_ODA_MD ? windowSize : 0);
+        EV_WARN << "CH: per-source models of the checkpoint do not fit this run, starting empty\n";
+    }
+    if (!perSourceModels && (savedEwma.isWarm() || !baseline.isLoaded())) {
+        ewma.resume(savedEwma);     // A cold one would undo the baseline seed
+        refEwma.resume(savedRefEwma);
+    }
+
+    std::vector<int32_t> subsetPositions;
+    in.getVector(subsetPositions);
+    for (int32_t p : subsetPositions) {
+        int i = p - dropped;
+        if (i >= 0 && i < (int)slidingWindow.size()) mcdSubset.push_back(slidingWindow[i]->getId());
+    }
+    in.get(mcdFits);
+    in.get(mcdStepsRun);
+    in.getMap(sensorErrorCount);
+    in.getMap(sensorTotalCount);
+
+    metrics.load(in);
+    altMetrics.load(in);
+    refMetrics.load(in);
+    in.get(decisionFlips);
+    in.get(fixedSaturations);
+    in.get(energy);
+
+    if (!in.finish())
+        throw cRuntimeError("Checkpoint '%s' is truncated or corrupt", filename.c_str());
+
+    EV << "CH restored from " << filename << " at t=" << at << ": "
+       << slidingWindow.size() << " samples in the window, "
+       << metrics.getTotalSamples() << " decisions so far\n";
+    return at;
+}
+
+// Round completion time = last response of a requestId - request sent
+void ClusterHead::trackRoundResponse(SensorMsg *msg)
+{
+    auto it = pendingRounds.find(msg->getRequestId());
+    if (it == pendingRounds.end()) return;
+
+    if (--it->second.outstanding == 0) {
+        emit(roundCompletionSignal, simTime() - it->second.sentAt);
+        pendingRounds.erase(it);
+    }
+}
+
 void ClusterHead::finish()
 {
     cancelAndDelete(logTimer);
     cancelAndDelete(requestTimer);
+    cancelAndDelete(aggregationTimer);
+    cancelAndDelete(modelReportTimer);
+    cancelAndDelete(serviceTimer);
+    cancelAndDelete(roundDeadlineTimer);
+    cancelAndDelete(checkpointTimer);
+    for (SensorMsg *m : roundBatch) delete m;
+    roundBatch.clear();
+    for (auto& round : readyRounds) {
+        for (SensorMsg *m : round.samples) delete m;
+    }
+    readyRounds.clear();
+    for (cMessage *out : heldOutput) delete out;
+    heldOutput.clear();
+    serviceQueue.clear();
     
     // Clean up remaining messages in sliding window
     for (auto msg : slidingWindow) {
@@ -685,18 +2231,44 @@ void ClusterHead::finish()
     EV << "\n========================================\n";
     EV << "     CLUSTER HEAD FINAL REPORT\n";
     EV << "========================================\n";
-    EV << "Algorithm: " << (algorithm == ALG_ODA_MD ? "ODA-MD (Sliding Window)" : "OD (Batch)") << "\n";
+    EV << "Algorithm: " << (algorithm == ALG_ODA_MD ? "ODA-MD (Sliding Window)"
+                           : algorithm == ALG_EWMA_MD ? "EWMA-MD (Exponentially Weighted)"
+                           : algorithm == ALG_MCD_MD ? "MCD-MD (Sliding Window, Robust)"
+                           : algorithm == ALG_LOF ? "LOF (Sliding Window, Density)" : "OD (Batch)") << "\n";
     EV << "Threshold: " << threshold << "\n";
-    EV << "Window Size: " << WINDOW_SIZE << "\n";
+    EV << "Window Size: " << windowSize << "\n";
     EV << "----------------------------------------\n";
     EV << "Total Received:    " << totalPacketsReceived << "\n";
     EV << "Outliers Detected: " << totalOutliersDetected << "\n";
     EV << "Packets Forwarded: " << totalPacketsForwarded << "\n";
+    if (aggregation) {
+        EV << "Summaries Sent:    " << totalSummariesSent
+           << " (every " << aggregationInterval << "s)\n";
+    }
     EV << "Energy Consumed:   " << energy.getConsumedEnergyMJ() << " mJ\n";
+    if (modelProcessingDelay) {
+        EV << "CPU Utilization:   " << (busyTime / simTime()) * 100 << "%"
+           << ", dropped " << droppedPackets << " (" << droppedOutliers << " outliers)\n";
+    }
     EV << "----------------------------------------\n";
 
     metrics.printSummary();
 
+    if (shadowReference && refMetrics.getTotalSamples() > 0) {
+        EV << "\nNUMERIC TYPE " << kernels.name << " vs double:\n"
+           << "  MD error: mean " << mdError.getMean() << ", max " << mdError.getMax() << "\n"
+           << "  Decision flips: " << decisionFlips << "/" << refMetrics.getTotalSamples() << "\n"
+           << "  DA delta: " << (metrics.getDetectionAccuracy() - refMetrics.getDetectionAccuracy()) * 100 << "%"
+           << ", FAR delta: " << (metrics.getFalseAlarmRate() - refMetrics.getFalseAlarmRate()) * 100 << "%\n"
+           << "  Fixed-point saturations: " << fixedSaturations << "\n";
+    }
+
+    if (altMetrics.getTotalSamples() > 0) {
+        EV << "\n" << (useGlobalModel ? "LOCAL" : "GLOBAL")
+           << " MODEL (shadow, not used for decisions):\n";
+        altMetrics.printSummary();
+    }
+
     // =========================================================================
     // OD ALGORITHM STEP 4: Measuring Sensor Trustfulness (Fawzy et al., 2013)
     // Paper: "Trust(s_i) = 1 - (N_ol / N_i)"
@@ -735,8 +2307,103 @@ void ClusterHead::finish()
         EV << "========================================\n";
     }
 
-    std::string csvFile = (algorithm == ALG_ODA_MD) ? "metrics_odamd.csv" : "metrics_od.csv";
-    metrics.exportToCSV(csvFile);
+    metrics.closeLog();
+    if (arrivals.isOpen()) {
+        recordScalar("arrivalsRecorded", (double)arrivals.getCount());
+        arrivals.close();
+    }
+
+    recordScalar("detectionAccuracy", metrics.getDetectionAccuracy());
+    recordScalar("falseAlarmRate", metrics.getFalseAlarmRate());
+    recordScalar("precision", metrics.getPrecision());
+    recordScalar("truePositives", metrics.getTP());
+    recordScalar("falsePositives", metrics.getFP());
+    recordScalar("trueNegatives", metrics.getTN());
+    recordScalar("falseNegatives", metrics.getFN());
+    recordScalar("eventsHandled", eventsHandled);
+    recordScalar("packetsReceived", totalPacketsReceived);
+    if (firstDecisionTime >= SIMTIME_ZERO) recordScalar("firstDecisionTime", firstDecisionTime.dbl(), "s");
+    if (batchesReceived > 0) recordScalar("batchesReceived", batchesReceived);
+    if (perSourceModels) {
+        recordScalar("sourceModels", sourceArena.getNumSlots());
+        recordScalar("sourceModelBytes", (double)(sourceArena.getBytes() + sourceEwma.capacity() * sizeof(EwmaModel)
+                                                  + sourceRefEwma.capacity() * sizeof(EwmaModel)), "B");
+    }
+    if (algorithm == ALG_LOF && lofIndex.getUpdates() > 0) {
+        // Work per index update (one insert or evict)
+        double updates = lofIndex.getUpdates();
+        recordScalar("lofDistancesPerUpdate", lofIndex.getDistanceEvals() / updates);
+        recordScalar("lofLrdUpdatesPerUpdate", lofIndex.getLrdEvals() / updates);
+        recordScalar("lofScoreUpdatesPerUpdate", lofIndex.getLofEvals() / updates);
+    }
+    if (algorithm == ALG_MCD_MD) {
+        recordScalar("mcdFits", mcdFits);
+        recordScalar("mcdCStepsPerFit", mcdFits > 0 ? (double)mcdStepsRun / mcdFits : 0.0);
+    }
+    if (encodedReceived > 0) {
+        recordScalar("encodedReceived", encodedReceived);
+        recordScalar("encodedBitsPerPacket", (double)encodedBits / encodedReceived);
+        recordScalar("decodeErrors", decodeErrors);
+    }
+    recordScalar("packetsForwarded", totalPacketsForwarded);
+    if (aggregation) {
+        // Tail of the last interval, never summarized: the Sink's
+        // cleanSamplesReceived plus these (over all CHs) is packetsForwarded
+        recordScalar("summariesSent", totalSummariesSent);
+        recordScalar("unsummarizedSamples", intervalStats.getCount());
+        recordScalar("unsummarizedOutliers", (double)intervalOutliers.size());
+    }
+    recordScalar("energyConsumed", energy.getConsumedEnergyMJ(), "mJ");
+    recordScalar("flops", totalOps.flops());
+    recordScalar("flopAdds", totalOps.adds);
+    recordScalar("flopMuls", totalOps.muls);
+    recordScalar("flopDivs", totalOps.divs);
+    recordScalar("flopSqrts", totalOps.sqrts);
+    recordScalar("flopsPerDecision", metrics.getTotalSamples() > 0
+                 ? (double)totalOps.flops() / metrics.getTotalSamples() : 0.0);
+    recordScalar("cpuCycles", totalCycles);
+    recordScalar("cyclesPerDecision", metrics.getTotalSamples() > 0
+                 ? totalCycles / metrics.getTotalSamples() : 0.0);
+    if (shadowReference) {
+        recordStatistic(&mdError);
+        recordScalar("decisionFlips", decisionFlips);
+        recordScalar("fixedSaturations", fixedSaturations);
+        recordScalar("refDetectionAccuracy", refMetrics.getDetectionAccuracy());
+        recordScalar("refFalseAlarmRate", refMetrics.getFalseAlarmRate());
+        recordScalar("deltaDetectionAccuracy", metrics.getDetectionAccuracy() - refMetrics.getDetectionAccuracy());
+        recordScalar("deltaFalseAlarmRate", metrics.getFalseAlarmRate() - refMetrics.getFalseAlarmRate());
+    }
+    profiler.recordScalars(this);  // Empty unless built with PROFILING=1
+    decisionLatency.recordScalars(this);
+    recordScalar("incompleteRounds", incompleteRounds + pendingRounds.size());
+    recordScalar("requestsSent", requestId);
+    if (adaptiveSampling) {
+        // Requests saved compared with fixed-rate polling at minRequestInterval
+        double fixedRateRequests = std::floor((simTime().dbl() - 0.1) / minRequestInterval) + 1;
+        recordScalar("meanRequestInterval", requestId > 0 ? requestTimeTotal / requestId : 0.0, "s");
+        recordScalar("requestsSaved", std::max(0.0, fixedRateRequests - requestId));
+    }
+    if (roundBatching) {
+        recordScalar("roundsProcessed", roundsProcessed);
+        recordScalar("meanRoundSize", roundsProcessed > 0 ? (double)roundSamples / roundsProcessed : 0.0);
+        recordScalar("roundsClosedIncomplete", roundsClosedIncomplete);
+        recordScalar("lateResponses", lateResponses);
+    }
+    if (modelProcessingDelay) {
+        recordScalar("cpuUtilization", simTime() > 0 ? busyTime / simTime() : 0.0);
+        recordScalar("droppedPackets", droppedPackets);
+        // Dropped outliers never reach metrics: DA with them counted as missed
+        long missed = metrics.getFN() + droppedOutliers;
+        recordScalar("droppedOutliers", droppedOutliers);
+        recordScalar("detectionAccuracyWithDrops", metrics.getTP() + missed > 0
+                     ? (double)metrics.getTP() / (metrics.getTP() + missed) : 0.0);
+    }
+
+    if (trace.isEnabled()) {
+        dumpTrace();
+        EV << "Trace: last " << trace.getCount()
+           << " of " << trace.getTotal() << " decisions -> " << traceFile << "\n";
+    }
 
     if (chData != nullptr) {
         delete chData;
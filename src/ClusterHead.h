@@ -15,16 +15,49 @@
 #include "MetricsCollector.h"
 #include "EnergyModel.h"
 #include "IntelLabData.h"
+#include "SufficientStats.h"
+#include "OutputPaths.h"
+#include "StageTimer.h"
+#include "TraceRing.h"
+#include "LatencyStats.h"
+#include "DetectorMath.h"
+#include "EwmaModel.h"
+#include "SourceArena.h"
+#include "McdEstimator.h"
+#include "IncrementalLof.h"
+#include "PayloadCodec.h"
+#include "ArrivalTrace.h"
+#include "Checkpoint.h"
+#include "BaselineModel.h"
+
+class LiveGateway;
 
 using namespace omnetpp;
 
 enum Algorithm {
     ALG_ODA_MD,
-    ALG_OD
+    ALG_OD,
+    ALG_EWMA_MD,
+    ALG_MCD_MD,
+    ALG_LOF
 };
 
-// Sliding Window size for real-time processing
-const int WINDOW_SIZE = 20;
+// Hot-path stages timed by StageProfiler (order matches the names in initialize())
+enum ProfileStage {
+    STAGE_WINDOW_TO_MATRIX,
+    STAGE_MEAN,
+    STAGE_COVARIANCE,
+    STAGE_INVERSION,
+    STAGE_MAHALANOBIS,
+    STAGE_METRICS,
+    STAGE_SEND,
+    STAGE_OD_CLUSTERING,
+    STAGE_OD_DETECTION,
+    STAGE_OD_CLASSIFICATION,
+    STAGE_LOF_UPDATE,       // Index insert/evict and neighbourhood updates
+    STAGE_PACKET_TOTAL,     // Whole handling of one SensorMsg
+    NUM_PROFILE_STAGES
+};
 
 class ClusterHead : public cSimpleModule
 {
@@ -32,6 +65,7 @@ class ClusterHead : public cSimpleModule
     double threshold;
     Algorithm algorithm;
     int chMoteId;
+    int windowSize;         // Sliding Window size for real-time processing
 
     // Sliding Window for real-time ODA-MD (replaces block batching)
     std::deque<SensorMsg *> slidingWindow;
@@ -41,10 +75,21 @@ class ClusterHead : public cSimpleModule
 
     MetricsCollector metrics;
     EnergyModel energy;
+    StageProfiler profiler;  // Per-stage CPU time (only filled with ODAMD_PROFILING)
+    TraceRing trace;         // Binary per-sample decision trace (traceRingSize > 0)
+    std::string traceFile;
+    bool traceDumped;
 
     int totalPacketsReceived;
     int totalOutliersDetected;
     int totalPacketsForwarded;
+    long batchesReceived;                   // SensorBatchMsg responses (batched sensors)
+    std::map<int, PayloadCodec::State> decoders;  // Per-source delta reference (EncodedSensorMsg)
+    long encodedReceived;                   // EncodedSensorMsg responses
+    long encodedBits;                       // Their charged size
+    long decodeErrors;                      // Undecodable payloads (dropped)
+    long eventsHandled;                     // All messages handled (benchmarking)
+    ArrivalTraceWriter arrivals;            // Arrival trace for TraceReplaySource (recordArrivals)
     
     // Flag to track if initial window has been processed
     bool isInitialWindowProcessed;
@@ -58,6 +103,147 @@ class ClusterHead : public cSimpleModule
     int numSensors;
     int requestId;
 
+    // Adaptive sampling: requestInterval grows while the window is stable and
+    // shrinks as soon as scores rise or outliers appear (between the two
+    // thresholds it is held: hysteresis)
+    bool adaptiveSampling;
+    double minRequestInterval;
+    double maxRequestInterval;
+    double adaptFactor;                     // Multiplicative step
+    int stableRounds;                       // Stable rounds needed before lengthening
+    double stableScoreFraction;             // Max MD < fraction * threshold -> stable
+    double unstableScoreFraction;           // Max MD >= fraction * threshold -> unstable
+    double covChangeTolerance;              // Relative Frobenius change of the covariance
+    int stableCount;
+    double adaptMaxScore;                   // Since the last adaptation
+    int adaptOutliers;
+    std::vector<std::vector<double>> windowCov;     // Latest window covariance
+    std::vector<std::vector<double>> adaptCov;      // Covariance at the last adaptation
+    double requestTimeTotal;                // Sum of intervals used (mean interval)
+    simsignal_t requestIntervalSignal;
+
+    // Latency tracking: sense -> decision per source, round completion per requestId
+    struct PendingRound {
+        simtime_t sentAt;
+        int outstanding;        // Responses still missing
+    };
+    std::map<int, PendingRound> pendingRounds;
+    long incompleteRounds;      // Rounds dropped before all responses arrived
+    LatencyStats decisionLatency;
+    simsignal_t senseToDecisionSignal;
+    simsignal_t roundCompletionSignal;
+    LiveGateway *liveGateway;   // Live feed on in[]: released decisions go back to it
+
+    // CPU service queue: each SensorMsg occupies the CH for the MICA2 processing
+    // delay of the operations it triggers; arrivals meanwhile wait in serviceQueue
+    bool modelProcessingDelay;
+    int queueCapacity;                      // Waiting packets (0 = unbounded)
+    cQueue serviceQueue;
+    cMessage *serviceTimer;                 // End of the current service
+    bool inService;                         // Outputs are held until serviceTimer
+    double serviceCycles;                   // CPU cycles charged by the current service
+    OpCounts totalOps;                      // Detector arithmetic charged so far
+    double totalCycles;
+    std::vector<cMessage *> heldOutput;     // Sends released at the end of the service
+    struct Decision {
+        int sourceId;
+        int seqNo;
+        simtime_t senseTime;
+        double score;
+        bool detectedAsOutlier;
+    };
+    std::vector<Decision> heldDecisions;    // Decisions released at the end of the service
+    simtime_t busyTime;
+    long droppedPackets;
+    long droppedOutliers;                   // True outliers among them: never decided, missed
+    simsignal_t queueLengthSignal;
+    simsignal_t queueingTimeSignal;
+    simsignal_t serviceTimeSignal;
+    simsignal_t droppedSignal;
+
+    // Round batching: responses of one requestId are collected until all
+    // sensors answered (or the deadline / next request), then inserted into
+    // the window together and scored against a single model update
+    bool roundBatching;
+    double roundDeadline;                   // After the request (0 = until the next request)
+    cMessage *roundDeadlineTimer;
+    int openRoundId;
+    std::vector<SensorMsg *> roundBatch;    // Samples of the open round
+    int roundResponses;                     // Responses (not samples) in the open round
+    struct ReadyRound {
+        simtime_t readyAt;
+        std::vector<SensorMsg *> samples;
+    };
+    std::deque<ReadyRound> readyRounds;     // Closed rounds waiting for the CPU
+    long roundsProcessed;
+    long roundSamples;
+    long roundsClosedIncomplete;            // Deadline or next request came first
+    long lateResponses;                     // Arrived after their round was closed
+
+    // CH-side aggregation: periodic SummaryMsg instead of per-sample forwarding
+    bool aggregation;
+    double aggregationInterval;
+    cMessage *aggregationTimer;
+    SufficientStats intervalStats;          // Clean samples of the current interval
+    std::vector<int> intervalOutliers;      // Sources of outliers blocked in the interval
+    simtime_t intervalStart;
+    int totalSummariesSent;
+
+    // Multi-cluster: local window model reported to Sink, global model received back
+    double modelReportInterval;
+    cMessage *modelReportTimer;
+    bool useGlobalModel;                    // Decide with the global model (local is shadow)
+    bool hasGlobalModel;
+    std::vector<double> globalMean;
+    std::vector<std::vector<double>> globalInvCov;
+    MetricsCollector altMetrics;            // Metrics of the model NOT used for decisions
+    std::string metricsFile;
+
+    // Warm start (baselineModel): precomputed mean / covariance pooled with
+    // the window while it fills (ODA-MD) or seeding the EWMA model, so every
+    // sample is scored on arrival
+    BaselineModel baseline;
+    double baselineWeight;                  // Pseudo-samples of the baseline with an empty window
+    simtime_t firstDecisionTime;            // < 0 until the first decision
+
+    // Detector arithmetic (numericType) and the double-precision shadow used
+    // to measure the accuracy of the float / fixed-point kernels
+    DetectorMath::Kernels kernels;
+    DetectorMath::Kernels reference;
+    bool shadowReference;                   // numericType != "double"
+    bool refValid;                          // Shadow model of the current window
+    std::vector<double> refMean;
+    DetectorMath::Matrix refInvCov;
+    MetricsCollector refMetrics;            // Decisions the double path would have made
+    cHistogram mdError;                     // |MD - MD_double|
+    long decisionFlips;
+    long fixedSaturations;
+
+    // EWMA-MD: exponentially weighted mean/covariance, no sample window
+    EwmaModel ewma;
+    EwmaModel refEwma;                      // Double shadow (numericType != "double")
+
+    // Per-source models (perSourceModels): each mote is scored against its
+    // own window / EWMA model, all held in arrays indexed by a dense slot
+    bool perSourceModels;
+    SourceArena sourceArena;                // Windows (ODA-MD)
+    std::vector<EwmaModel> sourceEwma;      // EWMA-MD models, by slot
+    std::vector<EwmaModel> sourceRefEwma;   // Their double shadows
+    DetectorMath::Matrix sourceX;           // Scratch: one source's window
+
+    // MCD-MD: robust window model from the h most central samples (C-steps)
+    int mcdCSteps;                          // C-steps per window update
+    int mcdInitialCSteps;                   // C-steps from the median start
+    double mcdSubsetFraction;               // h / n (0 = (n + 5) / 2)
+    std::vector<msgid_t> mcdSubset;         // Subset of the last fit, by message id
+    long mcdFits;
+    long mcdStepsRun;                       // C-steps that changed the subset
+
+    // LOF: incremental Local Outlier Factor over the sliding window, k-d tree
+    // backed; mirrors the window as (message id, index slot), oldest first
+    IncrementalLof lofIndex;
+    std::deque<std::pair<msgid_t, int>> lofSlots;
+
     // =========================================================================
     // OD Algorithm (Fawzy et al., 2013) - Data Structures
     // =========================================================================
@@ -73,6 +259,16 @@ class ClusterHead : public cSimpleModule
     std::map<int, int> sensorErrorCount;    // Error count per sensor (for trust)
     std::map<int, int> sensorTotalCount;    // Total readings per sensor
 
+    // Checkpoint / restore: detector state of this CH and its sensors saved at
+    // checkpointAt (first quiet point: no sample in service), resumed by runs
+    // with restoreDir set
+    cMessage *checkpointTimer;
+    std::string checkpointDir;
+
+  public:
+    ClusterHead() : decisionLatency("senseToDecision") {}
+    virtual ~ClusterHead();
+
   protected:
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
@@ -80,12 +276,78 @@ class ClusterHead : public cSimpleModule
 
     // Request-Response pattern
     void sendDataRequest();
+    void adaptRequestInterval();
+    void trackRoundResponse(SensorMsg *msg);
+
+    // Sensor responses: one SensorMsg, or a SensorBatchMsg / EncodedSensorMsg
+    // unpacked in order
+    std::vector<SensorMsg *> unpackBatch(SensorBatchMsg *batch);
+    std::vector<SensorMsg *> decodeResponse(EncodedSensorMsg *encoded);
+    void acceptResponse(std::vector<SensorMsg *>& samples);
+    void recordArrival(SensorMsg *msg);
+    void acceptSample(SensorMsg *msg);
+
+    // Per-sample processing and the CPU service queue
+    void processSample(SensorMsg *msg);
+    void startService(SensorMsg *msg);
+    void startRoundService(ReadyRound& round);
+    void startNextJob();
+    void beginService();
+    void scheduleServiceEnd();
+    void endService();
+    void chargeProcessing(double cycles);
+    void chargeKernelOps();
+    void sendToSink(cMessage *msg);
+    void noteDecision(const Decision& d);
+
+    // Round batching
+    void collectRoundResponse(std::vector<SensorMsg *>& samples);
+    void closeRound(bool complete);
+    void dispatchRound(std::vector<SensorMsg *>& samples);
+    void processRound(std::vector<SensorMsg *>& samples);
+
+    // Output path to Sink (raw forwarding or aggregation)
+    void forwardClean(SensorMsg *msg);
+    void noteOutlier(SensorMsg *msg);
+    void sendSummary();
+
+    // Per-sample decision bookkeeping: metrics, trace ring and debug log
+    void recordDecision(SensorMsg *msg, double score, bool detectedAsOutlier, const char *tag);
+    void dumpTrace();
+    std::string clusterSuffix() const;
+
+    // Multi-cluster model exchange
+    void sendModelReport();
+    void handleGlobalModel(ModelMsg *model);
+
+    // Checkpoint / restore (Checkpoint.h)
+    void writeCheckpoint();
+    simtime_t restoreCheckpoint(const std::string& filename);  // Returns the checkpoint time
 
     void loadCHData();
     void addCHReading();
 
+    // Accuracy of reduced-precision kernels against the double path
+    void buildReferenceModel(const DetectorMath::Matrix& X);
+    void setReferenceModel(const std::vector<double>& mean, const DetectorMath::Matrix& cov);
+    void compareWithReference(SensorMsg *msg, const std::vector<double>& x, double md, bool detected);
+    void noteReferenceDecision(SensorMsg *msg, double md, bool detected, double refMd, bool refOk);
+
     // ODA-MD Algorithm
-    void runODAMD();
+    void runODAMD(int newSamples = 1);  // Score the newest newSamples of the window
+
+    // MCD-MD: robust model of the window, warm-started from the last subset
+    bool fitMcdModel(const DetectorMath::Matrix& X, McdEstimator::Model& model);
+
+    // LOF: sync the index with the window, score the newest newSamples
+    void runLOF(int newSamples = 1);
+
+    // EWMA-MD: score one sample against the EWMA model, fold it in, release it
+    void runEWMAMD(SensorMsg *msg);
+
+    // Per-source models: score against the source's own model, then release
+    void runPerSource(SensorMsg *msg);
+    void releaseDecision(SensorMsg *msg, bool scored, double md, const char *tag);
     
     // OD Algorithm (Fawzy et al.) - Full 4-Step
     void runOD();
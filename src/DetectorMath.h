@@ -0,0 +1,414 @@
+//
+// Detector math kernels (ODA-MD, EWMA-MD and OD), templated on the arithmetic type
+// Inputs and outputs are double; T is the type the arithmetic runs in:
+//   double          release build, operations counted analytically
+//   Counted<double> make COUNT_OPS=1, every operation counted as executed
+//   float, Q16_16, Q8_24 reduced-precision variants for FPU-less motes
+//                   (FixedPoint.h), selected per run with numericType
+// All paths add to opTally() (OpCount.h); ClusterHead turns the counts into
+// MICA2 cycles with the per-type costs of its Kernels entry, and from there
+// into CPU energy and processing delay.
+//
+
+#ifndef __ODAMD_DETECTORMATH_H_
+#define __ODAMD_DETECTORMATH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+#include "OpCount.h"
+#include "FixedPoint.h"
+
+#ifdef ODAMD_COUNT_OPS
+typedef Counted<double> Real;
+#else
+typedef double Real;
+#endif
+
+namespace DetectorMath {
+
+typedef std::vector<std::vector<double>> Matrix;
+
+// Column means of an n x 4 window
+template <typename T>
+std::vector<double> mean(const Matrix& data)
+{
+    int n = data.size();
+    T acc[4] = {T(0.0), T(0.0), T(0.0), T(0.0)};
+    for (const auto& row : data) {
+        for (int j = 0; j < 4; j++) acc[j] += T(row[j]);
+    }
+    std::vector<double> result(4);
+    for (int j = 0; j < 4; j++) result[j] = static_cast<double>(acc[j] / T((double)n));
+
+    countOps<T>(4L * n, 0, 4, 0);
+    return result;
+}
+
+// Sample covariance (n - 1) with 0.001 added to the diagonal against singularity
+template <typename T>
+Matrix covariance(const Matrix& data, const std::vector<double>& mean)
+{
+    int n = data.size();
+    T m[4] = {T(mean[0]), T(mean[1]), T(mean[2]), T(mean[3])};
+    T cov[4][4];
+    for (int j = 0; j < 4; j++)
+        for (int k = 0; k < 4; k++)
+            cov[j][k] = T(0.0);
+
+    for (const auto& row : data) {
+        T d[4];
+        for (int j = 0; j < 4; j++) d[j] = T(row[j]) - m[j];
+        for (int j = 0; j < 4; j++) {
+            for (int k = 0; k < 4; k++) {
+                cov[j][k] += d[j] * d[k];
+            }
+        }
+    }
+
+    Matrix result(4, std::vector<double>(4));
+    for (int j = 0; j < 4; j++) {
+        for (int k = 0; k < 4; k++) {
+            T c = cov[j][k] / T((double)(n - 1));
+            if (j == k) c += T(0.001);
+            result[j][k] = static_cast<double>(c);
+        }
+    }
+
+    countOps<T>(4L * n + 16L * n + 4, 16L * n, 16, 0);
+    return result;
+}
+
+// Gauss-Jordan inversion with partial pivoting; false if (near) singular
+template <typename T>
+bool invert4x4(const Matrix& matrix, Matrix& inverse)
+{
+    using std::abs;
+    const int n = 4;
+    T aug[4][4], inv[4][4];
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            aug[i][j] = T(matrix[i][j]);
+            inv[i][j] = T((i == j) ? 1.0 : 0.0);
+        }
+    }
+
+    bool ok = true;
+    for (int i = 0; i < n && ok; i++) {
+        int maxRow = i;
+        for (int k = i + 1; k < n; k++) {
+            if (abs(aug[k][i]) > abs(aug[maxRow][i]))
+                maxRow = k;
+        }
+        std::swap(aug[i], aug[maxRow]);
+        std::swap(inv[i], inv[maxRow]);
+
+        T pivot = aug[i][i];
+        if (abs(pivot) < T(1e-9)) {
+            ok = false;
+            break;
+        }
+
+        for (int j = 0; j < n; j++) {
+            aug[i][j] /= pivot;
+            inv[i][j] /= pivot;
+        }
+
+        for (int k = 0; k < n; k++) {
+            if (k != i) {
+                T factor = aug[k][i];
+                for (int j = 0; j < n; j++) {
+                    aug[k][j] -= factor * aug[i][j];
+                    inv[k][j] -= factor * inv[i][j];
+                }
+            }
+        }
+        countOps<T>(2 * n * (n - 1), 2 * n * (n - 1), 2 * n, 0);
+    }
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            inverse[i][j] = static_cast<double>(inv[i][j]);
+    return ok;
+}
+
+// sqrt((x - mu)^T * invCov * (x - mu))
+template <typename T>
+double mahalanobis(const std::vector<double>& sample, const std::vector<double>& mean,
+                   const Matrix& invCov)
+{
+    using std::sqrt;
+    T diff[4];
+    for (int i = 0; i < 4; i++) diff[i] = T(sample[i]) - T(mean[i]);
+
+    T mdSq = T(0.0);
+    for (int i = 0; i < 4; i++) {
+        T temp = T(0.0);
+        for (int j = 0; j < 4; j++) {
+            temp += diff[j] * T(invCov[j][i]);
+        }
+        mdSq += temp * diff[i];
+    }
+
+    bool positive = mdSq > T(0.0);
+    countOps<T>(4 + 16 + 4, 16 + 4, 0, positive ? 1 : 0);
+    return positive ? static_cast<double>(sqrt(mdSq)) : 0.0;
+}
+
+template <typename T>
+double euclidean(const std::vector<double>& a, const std::vector<double>& b)
+{
+    using std::sqrt;
+    T sumSq = T(0.0);
+    for (int i = 0; i < 4; i++) {
+        T diff = T(a[i]) - T(b[i]);
+        sumSq += diff * diff;
+    }
+    countOps<T>(8, 4, 0, 1);
+    return static_cast<double>(sqrt(sumSq));
+}
+
+// OD: incremental centroid after adding x as the m-th member
+template <typename T>
+void updateCentroid(std::vector<double>& center, const std::vector<double>& x, int m)
+{
+    for (int j = 0; j < 4; j++) {
+        center[j] = static_cast<double>((T((double)(m - 1)) * T(center[j]) + T(x[j])) / T((double)m));
+    }
+    countOps<T>(4, 4, 4, 0);
+}
+
+// OD: average distance from each center to all other centers
+template <typename T>
+std::vector<double> interClusterDistances(const std::vector<std::vector<double>>& centers)
+{
+    int c = centers.size();
+    std::vector<double> avg(c, 0.0);
+    for (int i = 0; i < c; i++) {
+        T sumDist = T(0.0);
+        for (int j = 0; j < c; j++) {
+            if (i != j) sumDist += T(euclidean<T>(centers[i], centers[j]));
+        }
+        avg[i] = static_cast<double>(sumDist / T((double)(c - 1)));
+    }
+    countOps<T>((long)c * (c - 1), 0, c, 0);
+    return avg;
+}
+
+// Population mean and standard deviation
+template <typename T>
+void meanStd(const std::vector<double>& values, double& meanOut, double& stdOut)
+{
+    using std::sqrt;
+    int n = values.size();
+    T sum = T(0.0);
+    for (double v : values) sum += T(v);
+    T m = sum / T((double)n);
+
+    T variance = T(0.0);
+    for (double v : values) {
+        T diff = T(v) - m;
+        variance += diff * diff;
+    }
+    meanOut = static_cast<double>(m);
+    stdOut = static_cast<double>(sqrt(variance / T((double)n)));
+
+    countOps<T>(3L * n, n, 2, 1);
+}
+
+// EWMA-MD: score x against the model, then fold it in with weight alpha
+//   mean' = mean + alpha * d                      (d = x - mean)
+//   cov'  = (1 - alpha) * (cov + alpha * d d^T)
+//   inv'  = (inv - c * u u^T) / (1 - alpha)       (u = inv d, c = alpha / (1 + alpha d^T u))
+// The inverse follows by Sherman-Morrison (rank-1, O(d^2)); d^T u is the
+// squared MD, so scoring is part of the update. inv == nullptr updates mean
+// and covariance only (warm-up, no model to score against yet). The state
+// is plain arrays so per-source models can live in one block of memory.
+template <typename T>
+double ewmaUpdate(const std::vector<double>& x, double alpha, double mean[4],
+                  double cov[4][4], double (*inv)[4])
+{
+    using std::sqrt;
+    T a = T(alpha);
+    T keep = T(1.0) - a;
+    T d[4];
+    for (int j = 0; j < 4; j++) d[j] = T(x[j]) - T(mean[j]);
+
+    double md = 0.0;
+    if (inv != nullptr) {
+        T u[4];
+        T q = T(0.0);
+        for (int j = 0; j < 4; j++) {
+            u[j] = T(0.0);
+            for (int k = 0; k < 4; k++) u[j] += T(inv[j][k]) * d[k];
+            q += d[j] * u[j];
+        }
+        bool positive = q > T(0.0);
+        if (positive) md = static_cast<double>(sqrt(q));
+
+        T c = a / (T(1.0) + a * q);
+        T scale = T(1.0) / keep;
+        for (int j = 0; j < 4; j++)
+            for (int k = 0; k < 4; k++)
+                inv[j][k] = static_cast<double>((T(inv[j][k]) - c * u[j] * u[k]) * scale);
+        countOps<T>(16 + 4 + 1 + 16, 16 + 4 + 1 + 48, 2, positive ? 1 : 0);
+    }
+
+    for (int j = 0; j < 4; j++) {
+        mean[j] = static_cast<double>(T(mean[j]) + a * d[j]);
+        for (int k = 0; k < 4; k++)
+            cov[j][k] = static_cast<double>(keep * (T(cov[j][k]) + a * d[j] * d[k]));
+    }
+    countOps<T>(1 + 4 + 4 + 16, 4 + 48, 0, 0);
+    return md;
+}
+
+// Median of values already in T's precision: selection is comparisons
+// only, an even count averages the two middle values in T
+template <typename T>
+T median(std::vector<double> v)
+{
+    size_t mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + mid, v.end());
+    T upper = T(v[mid]);
+    if (v.size() % 2) return upper;
+    countOps<T>(1, 1, 0, 0);
+    return (T(*std::max_element(v.begin(), v.begin() + mid)) + upper) * T(0.5);
+}
+
+// MCD-MD start: squared distance of each row to the coordinate-wise
+// median, every feature scaled by its MAD (x 1.4826, at least 1e-6)
+template <typename T>
+std::vector<double> mcdMedianDistances(const Matrix& X)
+{
+    using std::abs;  // Counted / Fixed abs is not an arithmetic op, as in invert4x4
+    int n = X.size();
+    T med[4], mad[4];
+    std::vector<double> column(n);
+    for (int j = 0; j < 4; j++) {
+        for (int i = 0; i < n; i++) column[i] = static_cast<double>(T(X[i][j]));
+        med[j] = median<T>(column);
+        for (int i = 0; i < n; i++) {
+            T diff = T(X[i][j]) - med[j];
+            column[i] = static_cast<double>(abs(diff));
+        }
+        mad[j] = T(1.4826) * median<T>(column);
+        if (mad[j] < T(1e-6)) mad[j] = T(1e-6);
+    }
+    std::vector<double> dist(n);
+    for (int i = 0; i < n; i++) {
+        T acc = T(0.0);
+        for (int j = 0; j < 4; j++) {
+            T z = (T(X[i][j]) - med[j]) / mad[j];
+            acc += z * z;
+        }
+        dist[i] = static_cast<double>(acc);
+    }
+    countOps<T>(12L * n, 4L * n + 4, 4L * n, 0);
+    return dist;
+}
+
+// MCD-MD consistency factor: median(MD^2) / reference
+template <typename T>
+double mcdConsistency(const std::vector<double>& md, double reference)
+{
+    int n = md.size();
+    std::vector<double> sq(n);
+    for (int i = 0; i < n; i++) sq[i] = static_cast<double>(T(md[i]) * T(md[i]));
+    T c = median<T>(sq) / T(reference);
+    countOps<T>(0, n, 1, 0);
+    return static_cast<double>(c);
+}
+
+// MCD-MD rescaling of a model by c: covariance * c, inverse / c and the
+// MDs (if any) / sqrt(c)
+template <typename T>
+void mcdScale(Matrix& cov, Matrix& invCov, std::vector<double>& md, double c)
+{
+    using std::sqrt;
+    T factor = T(c);
+    for (int j = 0; j < 4; j++) {
+        for (int k = 0; k < 4; k++) {
+            cov[j][k] = static_cast<double>(T(cov[j][k]) * factor);
+            invCov[j][k] = static_cast<double>(T(invCov[j][k]) / factor);
+        }
+    }
+    if (!md.empty()) {
+        T root = sqrt(factor);
+        for (double& d : md) d = static_cast<double>(T(d) / root);
+    }
+    countOps<T>(0, 16, 16 + (long)md.size(), md.empty() ? 0 : 1);
+}
+
+// Approximate ATmega128L cycles per operation of each arithmetic type
+struct CycleCosts {
+    double add, mul, div, sqrt;
+
+    double cycles(const OpCounts& ops) const {
+        return ops.adds * add + ops.muls * mul + ops.divs * div + ops.sqrts * sqrt;
+    }
+};
+
+// One instantiation of the kernels, selectable at run time
+struct Kernels {
+    const char *name;
+    CycleCosts costs;
+    std::vector<double> (*mean)(const Matrix&);
+    Matrix (*covariance)(const Matrix&, const std::vector<double>&);
+    bool (*invert4x4)(const Matrix&, Matrix&);
+    double (*mahalanobis)(const std::vector<double>&, const std::vector<double>&, const Matrix&);
+    double (*euclidean)(const std::vector<double>&, const std::vector<double>&);
+    void (*updateCentroid)(std::vector<double>&, const std::vector<double>&, int);
+    std::vector<double> (*interClusterDistances)(const std::vector<std::vector<double>>&);
+    void (*meanStd)(const std::vector<double>&, double&, double&);
+    double (*ewmaUpdate)(const std::vector<double>&, double, double[4], double[4][4], double (*)[4]);
+    std::vector<double> (*mcdMedianDistances)(const Matrix&);
+    double (*mcdConsistency)(const std::vector<double>&, double);
+    void (*mcdScale)(Matrix&, Matrix&, std::vector<double>&, double);
+};
+
+template <typename T>
+Kernels kernelsFor(const char *name, CycleCosts costs)
+{
+    Kernels k;
+    k.name = name;
+    k.costs = costs;
+    k.mean = &mean<T>;
+    k.covariance = &covariance<T>;
+    k.invert4x4 = &invert4x4<T>;
+    k.mahalanobis = &mahalanobis<T>;
+    k.euclidean = &euclidean<T>;
+    k.updateCentroid = &updateCentroid<T>;
+    k.interClusterDistances = &interClusterDistances<T>;
+    k.meanStd = &meanStd<T>;
+    k.ewmaUpdate = &ewmaUpdate<T>;
+    k.mcdMedianDistances = &mcdMedianDistances<T>;
+    k.mcdConsistency = &mcdConsistency<T>;
+    k.mcdScale = &mcdScale<T>;
+    return k;
+}
+
+// The flat MICA2 model of EnergyModel (~100 cycles/FLOP) already assumes
+// 32-bit software floating point (avr-gcc double is 32-bit), so double and
+// float cost the same and differ only in accuracy. Fixed point: 32-bit
+// integer add/mul with saturation checks, 64-bit software divide and sqrt.
+inline bool selectKernels(const std::string& numericType, Kernels& k)
+{
+    if (numericType == "double")
+        k = kernelsFor<Real>("double", CycleCosts{100, 100, 100, 100});
+    else if (numericType == "float")
+        k = kernelsFor<float>("float", CycleCosts{100, 100, 100, 100});
+    else if (numericType == "q16.16")
+        k = kernelsFor<Q16_16>("q16.16", CycleCosts{8, 60, 700, 600});
+    else if (numericType == "q8.24")
+        k = kernelsFor<Q8_24>("q8.24", CycleCosts{8, 60, 700, 600});
+    else
+        return false;
+    return true;
+}
+
+}  // namespace DetectorMath
+
+#endif
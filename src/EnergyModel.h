@@ -19,6 +19,10 @@ class EnergyModel {
     static constexpr double E_DA = 5e-9;         // 5 nJ/bit - Data aggregation
     static constexpr double D0 = 87.0;           // Threshold distance (m)
 
+    // MICA2 CPU: 8MHz clock, ~100 cycles per floating-point operation (no FPU)
+    static constexpr double CYCLES_PER_FLOP = 100.0;
+    static constexpr double CLOCK_FREQ = 8e6;
+
     double currentEnergy;    // Current remaining energy (J)
     double consumedEnergy;   // Total consumed energy (J)
     double initialEnergy;    // Initial energy (J)
@@ -59,10 +63,15 @@ class EnergyModel {
         return energy;
     }
 
-    // CPU processing (for ODA-MD algorithm)
-    double process(int operations) {
+    // CPU processing: FLOPs counted by the DetectorMath kernels
+    double process(long operations) {
         // Giả định: 10 nJ per operation for matrix calculations
-        double energy = 10e-9 * operations;
+        return processCycles(operations * CYCLES_PER_FLOP);
+    }
+
+    // CPU processing in MICA2 cycles (10 nJ / 100 cycles per FLOP)
+    double processCycles(double cycles) {
+        double energy = 10e-9 / CYCLES_PER_FLOP * cycles;
         consumeEnergy(energy);
         return energy;
     }
@@ -108,15 +117,19 @@ class EnergyModel {
     // =========================================================================
     // MICA2 Processing Delay (Paper: ATmega128L @ 8MHz, no FPU)
     // =========================================================================
-    // Matrix 4x4 inversion: ~1000 FLOPs
+    // Operations come from the kernel op counts (OpCount.h); e.g. one sliding
+    // ODA-MD step on a 20-sample window is ~1100 FLOPs
     // MICA2 8MHz with software FP: ~100 cycles/FLOP
-    // Total: 1000 * 100 / 8MHz = 12.5ms per batch
+    // Total: 1100 * 100 / 8MHz = ~14ms per sample
     // =========================================================================
-    double getProcessingDelaySeconds(int operations) const {
-        // MICA2: 8MHz clock, ~100 cycles per floating-point operation (no FPU)
-        const double CYCLES_PER_FLOP = 100.0;
-        const double CLOCK_FREQ = 8e6;  // 8 MHz
-        double cycles = operations * CYCLES_PER_FLOP;
+    // Reduced-precision kernels (float, fixed point) have their own per-op
+    // cycle costs (DetectorMath::CycleCosts) and use getCycleDelaySeconds
+    // =========================================================================
+    double getProcessingDelaySeconds(long operations) const {
+        return getCycleDelaySeconds(operations * CYCLES_PER_FLOP);
+    }
+
+    double getCycleDelaySeconds(double cycles) const {
         return cycles / CLOCK_FREQ;
     }
 };
@@ -0,0 +1,170 @@
+//
+// Exponentially weighted mean / covariance model for EWMA-MD
+// Constant memory (mean, covariance and its inverse: O(d^2)), no samples
+// stored. Each sample is scored against the model and folded in with
+// weight alpha = 1 - lambda (DetectorMath::ewmaUpdate, Sherman-Morrison
+// update of the inverse).
+//
+// Warm-up: the first warmupSamples samples are folded in with alpha = 1/n
+// (exact running mean and covariance), then the covariance gets the same
+// 0.001 diagonal as ODA-MD and is inverted once. Every refreshInterval
+// updates the inverse is recomputed from the covariance and the diagonal
+// term, which decays by lambda per update, is topped up again. Without
+// this the rank-1 updates drift once the diagonal term has decayed and
+// the covariance is ill-conditioned (V varies ~1e-4 V^2, L ~1e4 lux^2).
+//
+
+#ifndef __ODAMD_EWMAMODEL_H_
+#define __ODAMD_EWMAMODEL_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "DetectorMath.h"
+
+// Trivially copyable (no heap members): per-source models are stored by
+// value in one contiguous array.
+class EwmaModel {
+  private:
+    double alpha;
+    int warmupSamples;
+    int refreshInterval;        // Updates between re-inversions (>= 1)
+
+    long count;
+    bool warm;
+    int sinceRefresh;
+    double mean[4];
+    double cov[4][4];
+    double inv[4][4];
+
+    static constexpr double RIDGE = 0.001;
+
+    static DetectorMath::Matrix toMatrix(const double m[4][4]) {
+        DetectorMath::Matrix out(4, std::vector<double>(4));
+        for (int j = 0; j < 4; j++)
+            for (int k = 0; k < 4; k++) out[j][k] = m[j][k];
+        return out;
+    }
+
+    // cov^-1 into inv (inv unchanged if singular)
+    bool invert(const DetectorMath::Kernels& k, const double c[4][4]) {
+        DetectorMath::Matrix fresh(4, std::vector<double>(4));
+        if (!k.invert4x4(toMatrix(c), fresh)) return false;
+        for (int j = 0; j < 4; j++)
+            for (int l = 0; l < 4; l++) inv[j][l] = fresh[j][l];
+        return true;
+    }
+
+  public:
+    EwmaModel() : alpha(0.05), warmupSamples(20), refreshInterval(1) { reset(); }
+
+    // Forgetting factor lambda from the half-life h in samples: lambda^h = 1/2
+    static double lambdaForHalfLife(double halfLife) {
+        return std::pow(0.5, 1.0 / halfLife);
+    }
+
+    void configure(double lambda, int warmup, int refresh) {
+        alpha = 1.0 - lambda;
+        warmupSamples = (warmup > 5) ? warmup : 5;  // Covariance of 4 features needs > 4 samples
+        refreshInterval = (refresh > 0) ? refresh : 1;
+        reset();
+    }
+
+    void reset() {
+        count = 0;
+        warm = false;
+        sinceRefresh = 0;
+        for (int j = 0; j < 4; j++) {
+            mean[j] = 0.0;
+            for (int k = 0; k < 4; k++) cov[j][k] = inv[j][k] = 0.0;
+        }
+    }
+
+    // Start warm from a known mean and covariance (baseline model) instead of
+    // warming up; false (still cold) if the covariance is singular
+    bool seed(const DetectorMath::Kernels& k, const std::vector<double>& m, const DetectorMath::Matrix& c) {
+        reset();
+        double seeded[4][4];
+        for (int j = 0; j < 4; j++) {
+            for (int l = 0; l < 4; l++) seeded[j][l] = c[j][l];
+            seeded[j][j] += RIDGE;
+        }
+        if (!invert(k, seeded)) return false;
+        for (int j = 0; j < 4; j++) {
+            mean[j] = m[j];
+            for (int l = 0; l < 4; l++) cov[j][l] = seeded[j][l];
+        }
+        warm = true;
+        return true;
+    }
+
+    // Learned state of a checkpointed model; the parameters stay as configured
+    void resume(const EwmaModel& saved) {
+        count = saved.count;
+        warm = saved.warm;
+        sinceRefresh = std::min(saved.sinceRefresh, refreshInterval - 1);
+        for (int j = 0; j < 4; j++) {
+            mean[j] = saved.mean[j];
+            for (int k = 0; k < 4; k++) {
+                cov[j][k] = saved.cov[j][k];
+                inv[j][k] = saved.inv[j][k];
+            }
+        }
+    }
+
+    bool isWarm() const { return warm; }
+    long getCount() const { return count; }
+    std::vector<double> getMean() const { return std::vector<double>(mean, mean + 4); }
+    DetectorMath::Matrix getCovariance() const { return toMatrix(cov); }
+
+    // Covariance without the diagonal term (RIDGE after warm-up or a
+    // refresh, decayed by lambda per update since), as reported to the Sink
+    DetectorMath::Matrix getDataCovariance() const {
+        DetectorMath::Matrix c = toMatrix(cov);
+        double ridge = RIDGE * std::pow(1.0 - alpha, sinceRefresh);
+        for (int j = 0; j < 4; j++) c[j][j] -= ridge;
+        return c;
+    }
+
+    // Window length with the same variance of the mean: (1 + lambda) / (1 - lambda)
+    double getEffectiveCount() const { return (2.0 - alpha) / alpha; }
+
+    // Score x against the current model (md), then fold it in.
+    // Returns false while warming up (no model to score against).
+    bool update(const DetectorMath::Kernels& k, const std::vector<double>& x, double& md) {
+        count++;
+        md = 0.0;
+
+        if (!warm) {
+            k.ewmaUpdate(x, 1.0 / count, mean, cov, nullptr);
+            if (count >= warmupSamples) {
+                // Population -> sample covariance plus the ODA-MD diagonal;
+                // if singular keep warming up and retry with the next sample
+                double sampleCov[4][4];
+                for (int j = 0; j < 4; j++) {
+                    for (int l = 0; l < 4; l++) sampleCov[j][l] = cov[j][l] * count / (count - 1);
+                    sampleCov[j][j] += RIDGE;
+                }
+                if (invert(k, sampleCov)) {
+                    for (int j = 0; j < 4; j++)
+                        for (int l = 0; l < 4; l++) cov[j][l] = sampleCov[j][l];
+                    warm = true;
+                }
+            }
+            return false;
+        }
+
+        md = k.ewmaUpdate(x, alpha, mean, cov, inv);
+        if (++sinceRefresh >= refreshInterval) {
+            // Top up the diagonal term, which decayed by lambda^refreshInterval
+            // since the last refresh, and re-invert
+            sinceRefresh = 0;
+            double ridge = RIDGE * (1.0 - std::pow(1.0 - alpha, refreshInterval));
+            for (int j = 0; j < 4; j++) cov[j][j] += ridge;
+            invert(k, cov);
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,121 @@
+//
+// Saturating 32-bit fixed-point number for FPU-less motes
+// Fixed<16> is Q16.16 (range +-32768, resolution 1.5e-5),
+// Fixed<24> is Q8.24 (range +-128, resolution 6e-8).
+// Every operation saturates instead of wrapping; saturations are counted
+// (takeSaturations()) so the accuracy report can show when a data range
+// does not fit the format.
+//
+
+#ifndef __ODAMD_FIXEDPOINT_H_
+#define __ODAMD_FIXEDPOINT_H_
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Saturation events since the last takeSaturations()
+inline long& fixedSaturationCount()
+{
+    static long count = 0;
+    return count;
+}
+
+inline long takeSaturations()
+{
+    long n = fixedSaturationCount();
+    fixedSaturationCount() = 0;
+    return n;
+}
+
+template <int FRAC>
+class Fixed {
+  private:
+    int32_t raw;
+
+    static constexpr int64_t ONE = int64_t(1) << FRAC;
+
+    static int32_t saturate(int64_t v) {
+        if (v > std::numeric_limits<int32_t>::max()) {
+            fixedSaturationCount()++;
+            return std::numeric_limits<int32_t>::max();
+        }
+        if (v < std::numeric_limits<int32_t>::min()) {
+            fixedSaturationCount()++;
+            return std::numeric_limits<int32_t>::min();
+        }
+        return (int32_t)v;
+    }
+
+    static Fixed fromRaw(int64_t v) {
+        Fixed f;
+        f.raw = saturate(v);
+        return f;
+    }
+
+  public:
+    Fixed() : raw(0) {}
+    Fixed(double x) {
+        double scaled = std::round(x * ONE);
+        if (scaled > 4e18) scaled = 4e18;      // Keep the int64 conversion defined
+        if (scaled < -4e18) scaled = -4e18;
+        raw = saturate((int64_t)scaled);
+    }
+    explicit operator double() const { return (double)raw / ONE; }
+
+    friend Fixed operator+(Fixed a, Fixed b) { return fromRaw((int64_t)a.raw + b.raw); }
+    friend Fixed operator-(Fixed a, Fixed b) { return fromRaw((int64_t)a.raw - b.raw); }
+    friend Fixed operator-(Fixed a) { return fromRaw(-(int64_t)a.raw); }
+
+    // 32x32 -> 64-bit product, rounded back to FRAC fraction bits
+    friend Fixed operator*(Fixed a, Fixed b) {
+        int64_t p = (int64_t)a.raw * b.raw;
+        return fromRaw((p + (ONE >> 1)) >> FRAC);
+    }
+
+    // Division by zero saturates towards the sign of the dividend
+    friend Fixed operator/(Fixed a, Fixed b) {
+        if (b.raw == 0) {
+            fixedSaturationCount()++;
+            return fromRaw(a.raw >= 0 ? std::numeric_limits<int32_t>::max()
+                                      : std::numeric_limits<int32_t>::min());
+        }
+        return fromRaw(((int64_t)a.raw * ONE) / b.raw);
+    }
+
+    Fixed& operator+=(Fixed o) { return *this = *this + o; }
+    Fixed& operator-=(Fixed o) { return *this = *this - o; }
+    Fixed& operator*=(Fixed o) { return *this = *this * o; }
+    Fixed& operator/=(Fixed o) { return *this = *this / o; }
+
+    friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+    friend Fixed abs(Fixed a) { return (a.raw < 0) ? -a : a; }
+
+    // Integer square root of raw << FRAC (bit-by-bit, as on the mote)
+    friend Fixed sqrt(Fixed a) {
+        if (a.raw <= 0) return Fixed();
+        uint64_t v = (uint64_t)a.raw << FRAC;
+        uint64_t result = 0;
+        uint64_t bit = uint64_t(1) << 62;
+        while (bit > v) bit >>= 2;
+        while (bit != 0) {
+            if (v >= result + bit) {
+                v -= result + bit;
+                result = (result >> 1) + bit;
+            } else {
+                result >>= 1;
+            }
+            bit >>= 2;
+        }
+        return fromRaw((int64_t)result);
+    }
+};
+
+typedef Fixed<16> Q16_16;
+typedef Fixed<24> Q8_24;
+
+#endif
@@ -0,0 +1,291 @@
+//
+// Incremental Local Outlier Factor over a sliding window (LOF detector)
+// LOF(p) = mean lrd of p's k nearest neighbours / lrd(p), with
+// lrd(p) = 1 / mean reach-dist(p, o) and reach-dist(p, o) = max(k-dist(o), d(p, o)).
+// ~1 inside a cluster of any shape, >> 1 for a point less dense than its
+// neighbours.
+//
+// Insert and remove only touch the points whose quantities change
+// (Pokrajac, Lazarevic & Latecki 2007):
+//   A      points whose k-neighbourhood changes: on insert, those within
+//          the largest k-dist of the new point (k-d tree range query) that
+//          it displaces, their lists patched; on remove, the removed
+//          point's reverse neighbours, re-queried
+//   S_lrd  A and every point with a member of A among its neighbours
+//          (its reach-distances use the changed k-dist)
+//   S_lof  S_lrd and every point with a member of S_lrd among its neighbours
+// S_lrd and S_lof are collected from reverse-neighbour lists, so an update
+// costs O(|S_lof| k) plus the tree queries, not a pass over the window.
+// Neighbourhoods are exactly k points, ordered by (distance, slot) as in
+// KdTree, so ties are resolved the same way by queries and patches. Distances are
+// Euclidean on readings divided by a per-feature scale, since T, H, L and V
+// differ by orders of magnitude. Arithmetic is double, counted per
+// distance / lrd / LOF evaluation.
+//
+
+#ifndef __ODAMD_INCREMENTALLOF_H_
+#define __ODAMD_INCREMENTALLOF_H_
+
+#include <algorithm>
+#include <set>
+#include <vector>
+#include "KdTree.h"
+
+class IncrementalLof {
+  public:
+    static const int DIM = KdTree::DIM;
+
+  private:
+    static constexpr double MIN_REACH = 1e-6;   // Duplicate readings: avoid lrd = inf
+
+    int k;
+    double scale[DIM];
+    std::vector<double> coords;     // slot * DIM, scaled
+    std::vector<char> live;
+    std::vector<int> freeSlots;
+    int liveCount;
+    bool valid;                     // Neighbourhoods complete (liveCount > k)
+    int updatesSinceRebuild;
+
+    // Per slot, k entries each: neighbour slots and distances, ascending
+    std::vector<int> knn;
+    std::vector<double> knnDist;
+    std::vector<double> lrd, lof;
+    std::vector<std::vector<int>> reverse;  // Per slot: slots with it among their neighbours
+    std::multiset<double> kDists;   // k-dist of every live slot (while valid)
+
+    KdTree tree;
+    KdTree::Neighbors found;
+    std::vector<char> inLrd, inLof; // Scratch: slots in S_lrd / S_lof, cleared after use
+
+    long updates;
+    long lrdEvals;
+    long lofEvals;
+
+    const double *point(int slot) const { return &coords[(size_t)slot * DIM]; }
+    double kDist(int slot) const { return knnDist[(size_t)slot * k + k - 1]; }
+
+    void queryNeighbors(int slot) {
+        tree.nearest(point(slot), k, slot, found);
+        for (int i = 0; i < k; i++) {
+            knn[(size_t)slot * k + i] = found[i].second;
+            knnDist[(size_t)slot * k + i] = found[i].first;
+        }
+    }
+
+    // Entered into / withdrawn from the reverse lists and kDists around
+    // every change of a neighbour list
+    void link(int slot) {
+        for (int i = 0; i < k; i++) reverse[knn[(size_t)slot * k + i]].push_back(slot);
+        kDists.insert(kDist(slot));
+    }
+
+    void unlink(int slot) {
+        for (int i = 0; i < k; i++) {
+            std::vector<int>& r = reverse[knn[(size_t)slot * k + i]];
+            *std::find(r.begin(), r.end(), slot) = r.back();
+            r.pop_back();
+        }
+        kDists.erase(kDists.find(kDist(slot)));
+    }
+
+    static void addTo(std::vector<int>& set, std::vector<char>& mark, int slot) {
+        if (mark[slot]) return;
+        mark[slot] = 1;
+        set.push_back(slot);
+    }
+
+    void updateLrd(int slot) {
+        double sum = 0.0;
+        for (int i = 0; i < k; i++) {
+            int o = knn[(size_t)slot * k + i];
+            sum += std::max(kDist(o), knnDist[(size_t)slot * k + i]);
+        }
+        lrd[slot] = k / std::max(sum, k * MIN_REACH);
+        lrdEvals++;
+        countOps<double>(k, 0, 1, 0);
+    }
+
+    void updateLof(int slot) {
+        double sum = 0.0;
+        for (int i = 0; i < k; i++) sum += lrd[knn[(size_t)slot * k + i]];
+        lof[slot] = sum / (k * lrd[slot]);
+        lofEvals++;
+        countOps<double>(k, 1, 1, 0);
+    }
+
+    // lrd of A and of the points reaching into A, then LOF one ring further
+    void propagate(const std::vector<int>& changed) {
+        std::vector<int> lrdSet, lofSet;
+        for (int q : changed) {
+            addTo(lrdSet, inLrd, q);
+            for (int o : reverse[q]) addTo(lrdSet, inLrd, o);
+        }
+        for (int o : lrdSet) updateLrd(o);
+
+        for (int q : lrdSet) {
+            addTo(lofSet, inLof, q);
+            for (int o : reverse[q]) addTo(lofSet, inLof, o);
+        }
+        for (int o : lofSet) updateLof(o);
+
+        for (int o : lrdSet) inLrd[o] = 0;
+        for (int o : lofSet) inLof[o] = 0;
+    }
+
+    void recomputeAll() {
+        for (auto& r : reverse) r.clear();
+        kDists.clear();
+        for (int s = 0; s < (int)live.size(); s++) {
+            if (live[s]) {
+                queryNeighbors(s);
+                link(s);
+            }
+        }
+        for (int s = 0; s < (int)live.size(); s++) {
+            if (live[s]) updateLrd(s);
+        }
+        for (int s = 0; s < (int)live.size(); s++) {
+            if (live[s]) updateLof(s);
+        }
+    }
+
+    void maybeRebuild() {
+        if (++updatesSinceRebuild < std::max(32, 2 * liveCount)) return;
+        std::vector<int> slots;
+        for (int s = 0; s < (int)live.size(); s++) {
+            if (live[s]) slots.push_back(s);
+        }
+        tree.rebuild(slots);
+        updatesSinceRebuild = 0;
+    }
+
+  public:
+    IncrementalLof() : k(5), liveCount(0), valid(false), updatesSinceRebuild(0),
+                       updates(0), lrdEvals(0), lofEvals(0) {
+        for (int j = 0; j < DIM; j++) scale[j] = 1.0;
+        tree.attach(&coords);
+    }
+
+    IncrementalLof(const IncrementalLof&) = delete;
+    IncrementalLof& operator=(const IncrementalLof&) = delete;
+
+    // featureScale: reading units per distance unit, one per feature (> 0)
+    void configure(int neighbors, const double featureScale[DIM]) {
+        k = std::max(1, neighbors);
+        for (int j = 0; j < DIM; j++) scale[j] = featureScale[j];
+        coords.clear();
+        live.clear();
+        freeSlots.clear();
+        knn.clear();
+        knnDist.clear();
+        lrd.clear();
+        lof.clear();
+        reverse.clear();
+        kDists.clear();
+        inLrd.clear();
+        inLof.clear();
+        liveCount = 0;
+        valid = false;
+        updatesSinceRebuild = 0;
+        tree.rebuild(std::vector<int>());
+    }
+
+    int getK() const { return k; }
+    int getSize() const { return liveCount; }
+    bool isReady() const { return valid; }      // Scores defined (more than k points)
+    double getLof(int slot) const { return lof[slot]; }
+
+    long getUpdates() const { return updates; }
+    long getDistanceEvals() const { return tree.getDistanceEvals(); }
+    long getLrdEvals() const { return lrdEvals; }
+    long getLofEvals() const { return lofEvals; }
+
+    // Add a reading (T, H, L, V); returns its slot
+    int insert(const std::vector<double>& x) {
+        int slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = live.size();
+            live.push_back(0);
+            coords.resize(coords.size() + DIM);
+            knn.resize(knn.size() + k);
+            knnDist.resize(knnDist.size() + k);
+            lrd.push_back(0.0);
+            lof.push_back(1.0);
+            reverse.emplace_back();
+            inLrd.push_back(0);
+            inLof.push_back(0);
+        }
+        for (int j = 0; j < DIM; j++) coords[(size_t)slot * DIM + j] = x[j] / scale[j];
+        countOps<double>(0, 0, DIM, 0);
+        live[slot] = 1;
+        liveCount++;
+        updates++;
+        tree.insert(slot);
+
+        if (liveCount <= k) return slot;
+        if (!valid) {
+            recomputeAll();
+            valid = true;
+            return slot;
+        }
+
+        // A: points the new one moves into the k-neighbourhood of (it beats
+        // their k-th neighbour in (distance, slot) order); their lists are
+        // patched in place, the k-th neighbour drops out. Only points within
+        // the largest k-dist can qualify.
+        tree.within(point(slot), *kDists.rbegin(), slot, found);
+        std::vector<int> changed(1, slot);
+        for (const auto& entry : found) {
+            int q = entry.second;
+            int *ids = &knn[(size_t)q * k];
+            double *dist = &knnDist[(size_t)q * k];
+            std::pair<double, int> inserted(entry.first, slot);
+            if (!(inserted < std::make_pair(dist[k - 1], ids[k - 1]))) continue;
+            unlink(q);
+            int i = k - 1;
+            for (; i > 0 && inserted < std::make_pair(dist[i - 1], ids[i - 1]); i--) {
+                ids[i] = ids[i - 1];
+                dist[i] = dist[i - 1];
+            }
+            ids[i] = slot;
+            dist[i] = entry.first;
+            link(q);
+            changed.push_back(q);
+        }
+        queryNeighbors(slot);
+        link(slot);
+        propagate(changed);
+        maybeRebuild();
+        return slot;
+    }
+
+    void remove(int slot) {
+        tree.remove(slot);
+        live[slot] = 0;
+        liveCount--;
+        freeSlots.push_back(slot);
+        updates++;
+
+        if (liveCount <= k) {
+            valid = false;
+            return;
+        }
+
+        // A: points that had the removed one as a neighbour, re-queried
+        unlink(slot);
+        std::vector<int> changed(reverse[slot]);   // Emptied by the unlinks
+        for (int q : changed) {
+            unlink(q);
+            queryNeighbors(q);
+            link(q);
+        }
+        propagate(changed);
+        maybeRebuild();
+    }
+};
+
+#endif
@@ -38,6 +38,7 @@ class IntelLabData {
     IntelLabData() : totalReadings(0), totalOutliers(0) {}
 
     // Load data from file, filtering by mote IDs and date range
+    // An empty moteIds list loads every mote in the file
     bool loadData(const std::string& filename,
                   const std::vector<int>& moteIds,
                   const std::string& startDate,
@@ -61,7 +62,7 @@ class IntelLabData {
             if (iss.fail()) continue;  // Skip malformed lines
 
             // Check if moteId is in our filter list
-            bool moteMatch = false;
+            bool moteMatch = moteIds.empty();
             for (int id : moteIds) {
                 if (reading.moteId == id) {
                     moteMatch = true;
@@ -84,6 +85,9 @@ class IntelLabData {
         for (int id : moteIds) {
             readIndex[id] = 0;
         }
+        for (const auto& pair : sensorData) {
+            readIndex[pair.first] = 0;
+        }
 
         return totalReadings > 0;
     }
@@ -242,6 +246,17 @@ class IntelLabData {
         return reading;
     }
 
+    // Read position of a mote (checkpoint / restore)
+    size_t getReadIndex(int moteId) const {
+        auto it = readIndex.find(moteId);
+        return (it != readIndex.end()) ? it->second : 0;
+    }
+
+    void setReadIndex(int moteId, size_t index) {
+        size_t count = getReadingsCount(moteId);
+        readIndex[moteId] = (count > 0) ? index % count : 0;
+    }
+
     // Get total readings count
     int getTotalReadings() const { return totalReadings; }
 
@@ -256,6 +271,15 @@ class IntelLabData {
 
     // Get total injected outliers
     int getTotalOutliers() const { return totalOutliers; }
+
+    // Get IDs of all loaded motes
+    std::vector<int> getMoteIds() const {
+        std::vector<int> ids;
+        for (const auto& pair : sensorData) {
+            ids.push_back(pair.first);
+        }
+        return ids;
+    }
 };
 
 #endif
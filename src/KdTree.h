@@ -0,0 +1,201 @@
+//
+// Bucket k-d tree over 4-D points for the LOF detector
+// Points live outside the tree (IncrementalLof's coordinate array, 4
+// doubles per slot); the tree stores slot numbers in leaf buckets. Insert
+// descends to a leaf and splits it once it holds 2 * LEAF_SIZE slots;
+// remove descends the same way (x[dim] < split goes left) and erases the
+// slot from its bucket, so both are O(depth) with no rebuild. The owner
+// calls rebuild() now and then to restore balance after many updates.
+//
+
+#ifndef __ODAMD_KDTREE_H_
+#define __ODAMD_KDTREE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "OpCount.h"
+
+class KdTree {
+  public:
+    static const int DIM = 4;
+    static const int LEAF_SIZE = 8;
+
+    // (distance, slot), ascending: equal distances are ordered by slot
+    typedef std::vector<std::pair<double, int>> Neighbors;
+
+  private:
+    struct Node {
+        int dim;                // Split dimension (-1 = leaf)
+        double split;
+        int left, right;
+        std::vector<int> bucket;
+    };
+
+    const std::vector<double> *coords;  // slot * DIM
+    std::vector<Node> nodes;
+    int size;
+    long distanceEvals;
+
+    const double *point(int slot) const { return &(*coords)[(size_t)slot * DIM]; }
+
+    int newLeaf() {
+        nodes.push_back(Node{-1, 0.0, -1, -1, std::vector<int>()});
+        return nodes.size() - 1;
+    }
+
+    // Split a leaf on its dimension of largest spread (median, or the
+    // midpoint when ties leave one side empty); stays a leaf if all equal
+    void splitLeaf(int n) {
+        std::vector<int> slots;
+        slots.swap(nodes[n].bucket);
+        double lo[DIM], hi[DIM];
+        for (int j = 0; j < DIM; j++) {
+            lo[j] = hi[j] = point(slots[0])[j];
+        }
+        for (int s : slots) {
+            for (int j = 0; j < DIM; j++) {
+                lo[j] = std::min(lo[j], point(s)[j]);
+                hi[j] = std::max(hi[j], point(s)[j]);
+            }
+        }
+        int dim = 0;
+        for (int j = 1; j < DIM; j++) {
+            if (hi[j] - lo[j] > hi[dim] - lo[dim]) dim = j;
+        }
+        if (hi[dim] <= lo[dim]) {
+            nodes[n].bucket.swap(slots);
+            return;
+        }
+
+        std::vector<double> values;
+        values.reserve(slots.size());
+        for (int s : slots) values.push_back(point(s)[dim]);
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        double split = values[values.size() / 2];
+        if (split <= lo[dim]) split = 0.5 * (lo[dim] + hi[dim]);
+
+        int left = newLeaf();
+        int right = newLeaf();
+        for (int s : slots) {
+            nodes[(point(s)[dim] < split) ? left : right].bucket.push_back(s);
+        }
+        nodes[n].dim = dim;
+        nodes[n].split = split;
+        nodes[n].left = left;
+        nodes[n].right = right;
+        if ((int)nodes[left].bucket.size() > LEAF_SIZE) splitLeaf(left);
+        if ((int)nodes[right].bucket.size() > LEAF_SIZE) splitLeaf(right);
+    }
+
+    int leafFor(const double *x) const {
+        int n = 0;
+        while (nodes[n].dim >= 0) {
+            n = (x[nodes[n].dim] < nodes[n].split) ? nodes[n].left : nodes[n].right;
+        }
+        return n;
+    }
+
+    // Branch and bound: nearer child first, farther one only if the
+    // splitting plane is not farther than the current k-th neighbour (a
+    // point on the plane may still win a tie by slot)
+    void search(int n, const double *q, int k, int exclude, Neighbors& best) {
+        const Node& node = nodes[n];
+        if (node.dim < 0) {
+            for (int s : node.bucket) {
+                if (s == exclude) continue;
+                std::pair<double, int> entry(distance(q, point(s)), s);
+                if ((int)best.size() == k) {
+                    if (!(entry < best.back())) continue;
+                    best.pop_back();
+                }
+                best.insert(std::upper_bound(best.begin(), best.end(), entry), entry);
+            }
+            return;
+        }
+        double gap = q[node.dim] - node.split;
+        int nearer = (gap < 0) ? node.left : node.right;
+        int farther = (gap < 0) ? node.right : node.left;
+        search(nearer, q, k, exclude, best);
+        if ((int)best.size() < k || std::fabs(gap) <= best.back().first) {
+            search(farther, q, k, exclude, best);
+        }
+    }
+
+    void collect(int n, const double *q, double radius, int exclude, Neighbors& out) {
+        const Node& node = nodes[n];
+        if (node.dim < 0) {
+            for (int s : node.bucket) {
+                if (s == exclude) continue;
+                double d = distance(q, point(s));
+                if (d <= radius) out.push_back(std::make_pair(d, s));
+            }
+            return;
+        }
+        double gap = q[node.dim] - node.split;
+        collect((gap < 0) ? node.left : node.right, q, radius, exclude, out);
+        if (std::fabs(gap) <= radius) collect((gap < 0) ? node.right : node.left, q, radius, exclude, out);
+    }
+
+  public:
+    KdTree() : coords(nullptr), size(0), distanceEvals(0) {}
+
+    void attach(const std::vector<double> *pointCoords) { coords = pointCoords; }
+
+    double distance(const double *a, const double *b) {
+        double sumSq = 0.0;
+        for (int j = 0; j < DIM; j++) {
+            double d = a[j] - b[j];
+            sumSq += d * d;
+        }
+        distanceEvals++;
+        countOps<double>(8, 4, 0, 1);
+        return std::sqrt(sumSq);
+    }
+
+    int getSize() const { return size; }
+    long getDistanceEvals() const { return distanceEvals; }
+
+    void rebuild(const std::vector<int>& slots) {
+        nodes.clear();
+        newLeaf();
+        nodes[0].bucket = slots;
+        size = slots.size();
+        if (size > LEAF_SIZE) splitLeaf(0);
+    }
+
+    void insert(int slot) {
+        if (nodes.empty()) newLeaf();
+        int leaf = leafFor(point(slot));
+        nodes[leaf].bucket.push_back(slot);
+        size++;
+        if ((int)nodes[leaf].bucket.size() >= 2 * LEAF_SIZE) splitLeaf(leaf);
+    }
+
+    // The slot's coordinates must be unchanged since insert
+    bool remove(int slot) {
+        if (nodes.empty()) return false;
+        std::vector<int>& bucket = nodes[leafFor(point(slot))].bucket;
+        auto it = std::find(bucket.begin(), bucket.end(), slot);
+        if (it == bucket.end()) return false;
+        *it = bucket.back();
+        bucket.pop_back();
+        size--;
+        return true;
+    }
+
+    // k nearest slots to q (fewer if the tree is smaller), exclude skipped
+    void nearest(const double *q, int k, int exclude, Neighbors& out) {
+        out.clear();
+        if (!nodes.empty() && k > 0) search(0, q, k, exclude, out);
+    }
+
+    // Slots within radius of q (inclusive, unordered), exclude skipped
+    void within(const double *q, double radius, int exclude, Neighbors& out) {
+        out.clear();
+        if (!nodes.empty()) collect(0, q, radius, exclude, out);
+    }
+};
+
+#endif
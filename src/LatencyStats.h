@@ -0,0 +1,43 @@
+//
+// Per-source latency histograms
+// One cHistogram per mote ID; written to the .sca file as
+// <name>:mote<id> statistics (seconds) at the end of the run
+//
+
+#ifndef __ODAMD_LATENCYSTATS_H_
+#define __ODAMD_LATENCYSTATS_H_
+
+#include <omnetpp.h>
+#include <map>
+#include <string>
+
+using namespace omnetpp;
+
+class LatencyStats {
+  private:
+    std::string name;
+    std::map<int, cHistogram *> bySource;
+
+  public:
+    LatencyStats(const char *statName) : name(statName) {}
+    ~LatencyStats() {
+        for (auto& pair : bySource) delete pair.second;
+    }
+
+    void record(int sourceId, simtime_t latency) {
+        cHistogram *& h = bySource[sourceId];
+        if (h == nullptr) {
+            h = new cHistogram((name + ":mote" + std::to_string(sourceId)).c_str());
+        }
+        h->collect(latency.dbl());
+    }
+
+    // Histograms -> .sca (called from finish())
+    void recordScalars(cComponent *owner) {
+        for (auto& pair : bySource) {
+            owner->recordStatistic(pair.second, "s");
+        }
+    }
+};
+
+#endif
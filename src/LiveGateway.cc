@@ -0,0 +1,169 @@
+//
+// LiveGateway - Live feed from a UNIX domain socket into a ClusterHead
+// Protocol (text lines, both directions):
+//   in:  <sourceId> <T> <H> <L> <V> [isOutlier]     ('#' lines ignored)
+//   out: <sourceId> <seqNo> <score> <detected 0|1> <latency us> <late 0|1>
+// Each input line becomes a SensorMsg on "out" (zero-delay link to the CH's
+// in[] gate) with a per-source seqNo counted from 0 in input order and
+// senseTime = ingest time. The CH calls decisionReleased() when a sample's
+// decision is final (after its CPU service with modelProcessingDelay); the
+// latency is wall clock from the socket read that completed the line (its
+// '\n', or the disconnect for an unterminated last line) to that call, -1
+// for a sample decided again after its first decision (OD). Samples that
+// never get a decision (window fill, queue drops) are counted as undecided.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "LiveGateway.h"
+#include <cstdio>
+#include <sstream>
+#include "StageTimer.h"
+
+Define_Module(LiveGateway);
+
+LiveGateway::~LiveGateway()
+{
+    cancelAndDelete(rxMsg);
+    cancelAndDelete(stopTimer);
+}
+
+void LiveGateway::initialize()
+{
+    scheduler = dynamic_cast<LiveSocketScheduler *>(getSimulation()->getScheduler());
+    if (scheduler == nullptr)
+        throw cRuntimeError("LiveGateway needs scheduler-class = \"LiveSocketScheduler\"");
+    rxMsg = new cMessage("liveInput");
+    stopTimer = new cMessage("stopTimer");
+    scheduler->setInterfaceModule(this, rxMsg);
+
+    latencyBudget = par("latencyBudget").doubleValue();
+    stopOnDisconnect = par("stopOnDisconnect").boolValue();
+    samplesIngested = 0;
+    decisionsSent = 0;
+    budgetMisses = 0;
+    undecided = 0;
+    malformedLines = 0;
+    ingestToDecisionSignal = registerSignal("ingestToDecision");
+    budgetMissSignal = registerSignal("budgetMiss");
+}
+
+void LiveGateway::handleMessage(cMessage *msg)
+{
+    if (msg == stopTimer) {
+        EV_INFO << "LiveGateway: feed closed, ending the run\n";
+        endSimulation();
+        return;
+    }
+    ASSERT(msg == rxMsg);
+
+    std::vector<int64_t> lineEnds;
+    std::string data = partialLine + scheduler->takeReceived(lineEnds);
+    size_t start = 0, line = 0;
+    for (size_t end; (end = data.find('\n', start)) != std::string::npos; start = end + 1) {
+        ingestLine(data.substr(start, end - start), lineEnds[line++]);
+    }
+    partialLine = data.substr(start);
+
+    if (scheduler->isPeerClosed()) {
+        // The disconnect ends a last line sent without '\n'
+        if (!partialLine.empty()) ingestLine(partialLine, scheduler->getClosedAt());
+        partialLine.clear();
+        // After the samples just sent (same time, scheduled earlier)
+        if (stopOnDisconnect && !stopTimer->isScheduled()) scheduleAt(simTime(), stopTimer);
+    }
+}
+
+void LiveGateway::ingestLine(const std::string& line, int64_t receivedAt)
+{
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#') return;  // Blank or comment
+
+    std::istringstream in(line);
+    int sourceId;
+    double temperature, humidity, light, voltage;
+    int isOutlier = 0;
+    if (!(in >> sourceId >> temperature >> humidity >> light >> voltage)) {
+        malformedLines++;
+        EV_WARN << "LiveGateway: malformed line '" << line << "'\n";
+        return;
+    }
+    in >> isOutlier;  // Optional ground truth
+
+    int seqNo = nextSeqNo[sourceId]++;
+    SensorMsg *s = new SensorMsg("SensorData");
+    s->setSourceId(sourceId);
+    s->setTemperature(temperature);
+    s->setHumidity(humidity);
+    s->setLight(light);
+    s->setVoltage(voltage);
+    s->setIsOutlier(isOutlier != 0);
+    s->setSenseTime(simTime());
+    s->setRequestId(-1);
+    s->setSeqNo(seqNo);
+    pending[sourceId].push_back(std::make_pair(seqNo, receivedAt));
+    send(s, "out");
+    samplesIngested++;
+}
+
+void LiveGateway::decisionReleased(int sourceId, int seqNo, double score, bool detectedAsOutlier)
+{
+    Enter_Method_Silent();
+    int64_t now = LiveSocketScheduler::wallClockUsecs();
+
+    // The CH decides each source's samples in order: older ones still
+    // pending were skipped
+    auto& queue = pending[sourceId];
+    while (!queue.empty() && queue.front().first < seqNo) {
+        queue.pop_front();
+        undecided++;
+    }
+    long long latency = -1;
+    bool late = false;
+    if (!queue.empty() && queue.front().first == seqNo) {
+        latency = now - queue.front().second;
+        queue.pop_front();
+        ingestToDecision.collect((double)latency);
+        emit(ingestToDecisionSignal, latency / 1e6);
+        late = latencyBudget > 0 && latency > latencyBudget * 1e6;
+        if (late) {
+            budgetMisses++;
+            emit(budgetMissSignal, latency / 1e6);
+            EV_WARN << "[LATE] Node" << sourceId << " #" << seqNo << " decided after "
+                    << latency << " us (budget " << latencyBudget * 1e6 << " us)\n";
+        }
+    }
+
+    char out[128];
+    snprintf(out, sizeof(out), "%d %d %.6g %d %lld %d\n",
+             sourceId, seqNo, score, detectedAsOutlier ? 1 : 0, latency, late ? 1 : 0);
+    scheduler->sendBytes(out);
+    decisionsSent++;
+}
+
+void LiveGateway::finish()
+{
+    for (const auto& pair : pending) undecided += pair.second.size();
+
+    recordScalar("samplesIngested", samplesIngested);
+    recordScalar("decisionsSent", decisionsSent);
+    recordScalar("undecided", undecided);
+    recordScalar("malformedLines", malformedLines);
+    recordScalar("latencyBudget", latencyBudget, "s");
+    recordScalar("budgetMisses", budgetMisses);
+    if (ingestToDecision.getCount() > 0) {
+        recordScalar("budgetMissRatio", (double)budgetMisses / ingestToDecision.getCount());
+        recordStatistic(&ingestToDecision, "us");
+        recordScalar("ingestToDecision:p50", StageProfiler::quantile(&ingestToDecision, 0.50), "us");
+        recordScalar("ingestToDecision:p95", StageProfiler::quantile(&ingestToDecision, 0.95), "us");
+        recordScalar("ingestToDecision:p99", StageProfiler::quantile(&ingestToDecision, 0.99), "us");
+        recordScalar("ingestToDecision:max", ingestToDecision.getMax(), "us");
+    }
+
+    EV_INFO << "LiveGateway: " << samplesIngested << " samples, " << decisionsSent << " decisions, "
+            << budgetMisses << " over the " << latencyBudget * 1e3 << " ms budget, "
+            << undecided << " undecided\n";
+}
@@ -0,0 +1,62 @@
+//
+// LiveGateway - Live feed from a UNIX domain socket into a ClusterHead
+// Interface module of LiveSocketScheduler: stands in for the SensorNodes,
+// streams the CH's decisions back to the client and measures wall-clock
+// ingest -> decision latency against a budget
+//
+
+#ifndef __ODAMD_LIVEGATEWAY_H_
+#define __ODAMD_LIVEGATEWAY_H_
+
+#include <omnetpp.h>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "messages_m.h"
+#include "LiveSocketScheduler.h"
+
+using namespace omnetpp;
+
+class LiveGateway : public cSimpleModule
+{
+  private:
+    LiveSocketScheduler *scheduler;
+    cMessage *rxMsg;                // Scheduler notification: input or disconnect
+    cMessage *stopTimer;
+    std::string partialLine;        // Unterminated tail of the last input
+    double latencyBudget;           // Seconds (0 = no budget)
+    bool stopOnDisconnect;
+
+    // Per source: next seqNo and (seqNo, ingest wall clock in us) of samples
+    // still waiting for a decision, oldest first
+    std::map<int, int> nextSeqNo;
+    std::map<int, std::deque<std::pair<int, int64_t>>> pending;
+
+    cHistogram ingestToDecision;    // Microseconds
+    long samplesIngested;
+    long decisionsSent;
+    long budgetMisses;
+    long undecided;                 // Overtaken by a later decision (window fill, drops)
+    long malformedLines;
+    simsignal_t ingestToDecisionSignal;
+    simsignal_t budgetMissSignal;
+
+  public:
+    LiveGateway() : rxMsg(nullptr), stopTimer(nullptr), ingestToDecision("ingestToDecision") {}
+    virtual ~LiveGateway();
+
+    // Called by the ClusterHead when the decision on a sample is final
+    void decisionReleased(int sourceId, int seqNo, double score, bool detectedAsOutlier);
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    void ingestLine(const std::string& line, int64_t receivedAt);
+};
+
+#endif
@@ -0,0 +1,248 @@
+//
+// LiveSocketScheduler - Real-time scheduler with a UNIX domain socket
+// Events are released when the wall clock reaches baseTime + their
+// simulation time. Waits are spent in select() on the socket, in slices
+// of at most 100 ms so the user interface stays responsive; input that
+// arrives during a wait is scheduled for "now" and may overtake the event
+// being waited for. If the simulation falls behind the wall clock, events
+// run back to back until it catches up, with a zero-timeout poll of the
+// socket before each one so input is still stamped when it is read. Each
+// line is stamped with the wall clock of the read holding its '\n'.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "LiveSocketScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+Register_Class(LiveSocketScheduler);
+
+Register_GlobalConfigOption(CFGID_LIVE_SOCKET_PATH, "live-socket-path", CFG_STRING, "odamd-live.sock",
+    "LiveSocketScheduler: UNIX domain socket the live feed connects to (created at the start of the run).");
+
+LiveSocketScheduler::LiveSocketScheduler()
+    : listenerSocket(-1), connSocket(-1), baseTime(0), module(nullptr),
+      notificationMsg(nullptr), peerClosed(false), closedAt(0)
+{
+}
+
+LiveSocketScheduler::~LiveSocketScheduler()
+{
+    closeSocket(connSocket);
+    closeSocket(listenerSocket);
+}
+
+std::string LiveSocketScheduler::str() const
+{
+    return "live socket " + socketPath + (connSocket >= 0 ? " (connected)" : " (waiting for a client)");
+}
+
+int64_t LiveSocketScheduler::wallClockUsecs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LiveSocketScheduler::startRun()
+{
+    socketPath = getEnvir()->getConfig()->getAsString(CFGID_LIVE_SOCKET_PATH);
+    setupListener();
+    executionResumed();
+}
+
+void LiveSocketScheduler::endRun()
+{
+    closeSocket(connSocket);
+#ifndef _WIN32
+    if (listenerSocket >= 0) unlink(socketPath.c_str());
+#endif
+    closeSocket(listenerSocket);
+}
+
+void LiveSocketScheduler::executionResumed()
+{
+    // Wall clock again from the current simulation time (after a pause)
+    baseTime = wallClockUsecs() - sim->getSimTime().inUnit(SIMTIME_US);
+}
+
+void LiveSocketScheduler::setInterfaceModule(cModule *mod, cMessage *msg)
+{
+    if (module != nullptr)
+        throw cRuntimeError("LiveSocketScheduler: interface module already set to %s", module->getFullPath().c_str());
+    module = mod;
+    notificationMsg = msg;
+}
+
+void LiveSocketScheduler::setupListener()
+{
+#ifdef _WIN32
+    throw cRuntimeError("LiveSocketScheduler: UNIX domain sockets are not supported on this platform");
+#else
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path))
+        throw cRuntimeError("LiveSocketScheduler: invalid live-socket-path '%s'", socketPath.c_str());
+    strcpy(addr.sun_path, socketPath.c_str());
+
+    // A socket left behind by a killed run is replaced, anything else is an error
+    struct stat st;
+    if (stat(socketPath.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode))
+            throw cRuntimeError("LiveSocketScheduler: '%s' exists and is not a socket", socketPath.c_str());
+        unlink(socketPath.c_str());
+    }
+
+    listenerSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenerSocket < 0)
+        throw cRuntimeError("LiveSocketScheduler: cannot create socket: %s", strerror(errno));
+    if (bind(listenerSocket, (sockaddr *)&addr, sizeof(addr)) < 0)
+        throw cRuntimeError("LiveSocketScheduler: cannot bind '%s': %s", socketPath.c_str(), strerror(errno));
+    if (listen(listenerSocket, 1) < 0)
+        throw cRuntimeError("LiveSocketScheduler: cannot listen on '%s': %s", socketPath.c_str(), strerror(errno));
+    EV_INFO << "LiveSocketScheduler: listening on " << socketPath << "\n";
+#endif
+}
+
+void LiveSocketScheduler::closeSocket(int& fd)
+{
+#ifndef _WIN32
+    if (fd >= 0) close(fd);
+#endif
+    fd = -1;
+}
+
+void LiveSocketScheduler::notifyModule()
+{
+    if (notificationMsg->isScheduled()) return;  // Not yet handled: it will take everything
+    simtime_t now(wallClockUsecs() - baseTime, SIMTIME_US);
+    if (now < sim->getSimTime()) now = sim->getSimTime();  // Behind the wall clock
+    notificationMsg->setArrival(module->getId(), -1, now);
+    sim->getFES()->insert(notificationMsg);
+}
+
+// True if the interface module was notified (input or disconnect)
+bool LiveSocketScheduler::receiveWithTimeout(int64_t usec)
+{
+#ifdef _WIN32
+    return false;
+#else
+    int fd = (connSocket >= 0) ? connSocket : listenerSocket;
+    fd_set readFds;
+    FD_ZERO(&readFds);
+    FD_SET(fd, &readFds);
+    timeval timeout;
+    timeout.tv_sec = usec / 1000000;
+    timeout.tv_usec = usec % 1000000;
+    if (select(fd + 1, &readFds, nullptr, nullptr, &timeout) <= 0) return false;
+
+    if (connSocket < 0) {
+        connSocket = accept(listenerSocket, nullptr, nullptr);
+        if (connSocket >= 0) {
+            peerClosed = false;
+            EV_INFO << "LiveSocketScheduler: client connected\n";
+        }
+        return false;
+    }
+
+    char buffer[4096];
+    ssize_t n = recv(connSocket, buffer, sizeof(buffer), 0);
+    int64_t now = wallClockUsecs();
+    if (n <= 0) {
+        closeSocket(connSocket);
+        peerClosed = true;
+        closedAt = now;
+        EV_INFO << "LiveSocketScheduler: client disconnected\n";
+    } else {
+        for (ssize_t i = 0; i < n; i++) {
+            if (buffer[i] == '\n') lineEnds.push_back(now);
+        }
+        received.append(buffer, n);
+    }
+    notifyModule();
+    return true;
+#endif
+}
+
+// 1: module notified, 0: target time reached, -1: interrupted by the user
+int LiveSocketScheduler::receiveUntil(int64_t targetTime)
+{
+    for (int64_t now = wallClockUsecs(); now < targetTime; now = wallClockUsecs()) {
+        if (receiveWithTimeout(std::min<int64_t>(targetTime - now, 100000))) return 1;
+        if (getEnvir()->idle()) return -1;
+    }
+    return 0;
+}
+
+cEvent *LiveSocketScheduler::guessNextEvent()
+{
+    return sim->getFES()->peekFirst();
+}
+
+cEvent *LiveSocketScheduler::takeNextEvent()
+{
+    if (module == nullptr)
+        throw cRuntimeError("LiveSocketScheduler: no interface module (a LiveGateway must be in the network)");
+
+    while (true) {
+        cEvent *event = sim->getFES()->peekFirst();
+        // Empty FES: wait for input indefinitely
+        int64_t targetTime = event ? baseTime + event->getArrivalTime().inUnit(SIMTIME_US) : INT64_MAX;
+        if (targetTime <= wallClockUsecs()) {
+            // Overdue: no wait, but read what has arrived (its notification
+            // goes after this event, at the current wall clock)
+            receiveWithTimeout(0);
+            break;
+        }
+        int status = receiveUntil(targetTime);
+        if (status == -1) return nullptr;
+        if (status == 0) break;
+        // Input arrived: its notification may now be the first event
+    }
+    return sim->getFES()->removeFirst();
+}
+
+void LiveSocketScheduler::putBackEvent(cEvent *event)
+{
+    sim->getFES()->putBackFirst(event);
+}
+
+std::string LiveSocketScheduler::takeReceived(std::vector<int64_t>& newlineTimes)
+{
+    newlineTimes.clear();
+    newlineTimes.swap(lineEnds);
+    std::string data;
+    data.swap(received);
+    return data;
+}
+
+void LiveSocketScheduler::sendBytes(const std::string& data)
+{
+#ifndef _WIN32
+    size_t sent = 0;
+    while (connSocket >= 0 && sent < data.size()) {
+        ssize_t n = send(connSocket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            EV_WARN << "LiveSocketScheduler: send failed (" << strerror(errno) << "), dropping the client\n";
+            closeSocket(connSocket);
+            peerClosed = true;
+            return;
+        }
+        sent += n;
+    }
+#endif
+}
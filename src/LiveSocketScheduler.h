@@ -0,0 +1,77 @@
+//
+// LiveSocketScheduler - Real-time scheduler with a UNIX domain socket for live ingestion
+// Simulation time follows the wall clock (1 simulated second per second
+// from the start of the run). While waiting for the next event the
+// scheduler listens on live-socket-path; bytes from the connected client
+// are handed to the interface module (LiveGateway) by inserting its
+// notification message into the FES at the current wall-clock time, and
+// sendBytes() writes back to the same client. One client at a time.
+// Modeled on the OMNeT++ sockets sample (cSocketRTScheduler). POSIX only.
+//
+// omnetpp.ini:
+//   scheduler-class = "LiveSocketScheduler"
+//   live-socket-path = "odamd-live.sock"
+//
+
+#ifndef __ODAMD_LIVESOCKETSCHEDULER_H_
+#define __ODAMD_LIVESOCKETSCHEDULER_H_
+
+#include <omnetpp.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace omnetpp;
+
+class LiveSocketScheduler : public cScheduler
+{
+  private:
+    std::string socketPath;
+    int listenerSocket;
+    int connSocket;
+    int64_t baseTime;               // Wall clock (us) at simulation time 0
+
+    cModule *module;                // Interface module and its notification
+    cMessage *notificationMsg;
+    std::string received;           // Bytes not yet taken by the module
+    std::vector<int64_t> lineEnds;  // Wall clock (us) of each '\n' in received
+    bool peerClosed;                // The client hung up (until the next one connects)
+    int64_t closedAt;               // Wall clock (us) of the hang-up
+
+    void setupListener();
+    void closeSocket(int& fd);
+    bool receiveWithTimeout(int64_t usec);
+    int receiveUntil(int64_t targetTime);
+    void notifyModule();
+
+  public:
+    LiveSocketScheduler();
+    virtual ~LiveSocketScheduler();
+
+    virtual std::string str() const override;
+    virtual void startRun() override;
+    virtual void endRun() override;
+    virtual void executionResumed() override;
+    virtual cEvent *guessNextEvent() override;
+    virtual cEvent *takeNextEvent() override;
+    virtual void putBackEvent(cEvent *event) override;
+
+    // Called from the interface module's initialize()
+    void setInterfaceModule(cModule *module, cMessage *notificationMsg);
+
+    // Bytes received since the last call, and the wall clock at which each
+    // '\n' in them was read
+    std::string takeReceived(std::vector<int64_t>& newlineTimes);
+    bool isPeerClosed() const { return peerClosed; }
+    // Also ends an unterminated last line
+    int64_t getClosedAt() const { return closedAt; }
+    bool isConnected() const { return connSocket >= 0; }
+
+    // Write to the connected client (dropped if there is none)
+    void sendBytes(const std::string& data);
+
+    // Monotonic wall clock, microseconds
+    static int64_t wallClockUsecs();
+};
+
+#endif
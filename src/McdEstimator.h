@@ -0,0 +1,130 @@
+//
+// Minimum Covariance Determinant (MCD) model for MCD-MD
+// The model is the mean/covariance of the h window samples with the
+// smallest MD under it, so outliers in the window do not inflate it.
+// Concentration steps (C-steps, Rousseeuw & Van Driessen 1999): fit
+// (mean, covariance) on the subset H, score all n samples, take the h
+// smallest MDs as the new H. Each C-step can only lower det(covariance).
+//
+// Instead of a fast-MCD restart per sample, the subset of the previous
+// window is carried over (evicted sample removed, newest added) and
+// refined with a fixed number of C-steps, so the cost per sample is
+// (steps + 2) x (fit + n MDs), the reweighting included. The first window
+// starts from the h samples closest to the coordinate-wise median
+// (median/MAD scaled) and runs more C-steps.
+//
+// The subset covariance is scaled by median(MD^2) / chi2_4(0.5), then the
+// model is refitted on all samples with MD^2 below chi2_4(0.975)
+// (reweighted MCD), so MDs of clean data are on the scale of the plain
+// window model and its threshold. All arithmetic, scaling and reweighting
+// included, runs in the kernels' type and is charged at its costs.
+//
+
+#ifndef __ODAMD_MCDESTIMATOR_H_
+#define __ODAMD_MCDESTIMATOR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "DetectorMath.h"
+
+class McdEstimator {
+  public:
+    static constexpr double CHI2_4_MEDIAN = 3.357;  // Median of chi-squared, 4 dof
+    static constexpr double CHI2_4_975 = 11.143;    // 97.5% quantile
+    static constexpr double REWEIGHT_CONSISTENCY = 1.0645;  // 0.975 / P(chi2_6 <= 11.143)
+    static constexpr double MD_975 = 3.338;         // sqrt(CHI2_4_975): inlier test without squaring
+
+    struct Model {
+        bool ok = false;
+        std::vector<double> mean;
+        DetectorMath::Matrix cov;       // Consistency-scaled
+        DetectorMath::Matrix invCov;
+        std::vector<double> md;         // MD of every window sample under the model
+        int stepsRun = 0;               // C-steps that changed the subset
+    };
+
+    // h = fraction * n, at least (n + d + 1) / 2 (maximum breakdown, also
+    // the value for fraction 0)
+    static int subsetSize(int n, double fraction) {
+        int hMin = (n + 4 + 1) / 2;
+        int h = (fraction > 0) ? (int)std::ceil(fraction * n) : hMin;
+        return std::max(hMin, std::min(h, n));
+    }
+
+    // h samples closest to the coordinate-wise median, each feature scaled by its MAD
+    static std::vector<int> initialSubset(const DetectorMath::Kernels& k, const DetectorMath::Matrix& X, int h) {
+        return smallest(k.mcdMedianDistances(X), h);
+    }
+
+    // Fit on H, then up to steps C-steps; H is updated in place. The
+    // returned model is fitted on the final H.
+    static Model concentrate(const DetectorMath::Kernels& k, const DetectorMath::Matrix& X,
+                             std::vector<int>& H, int steps) {
+        int n = X.size();
+        int h = H.size();
+        Model m;
+        for (int s = 0; ; s++) {
+            if (!fit(k, X, H, m)) return m;
+            m.md.resize(n);
+            for (int i = 0; i < n; i++) m.md[i] = k.mahalanobis(X[i], m.mean, m.invCov);
+            if (s == steps) break;
+
+            std::vector<int> next = smallest(m.md, h);
+            std::vector<int> sortedH = H;
+            std::sort(sortedH.begin(), sortedH.end());
+            if (next == sortedH) break;         // Converged: fixed point of the C-step
+            H = next;
+            m.stepsRun++;
+        }
+
+        // Consistency scaling: MD^2 of the clean majority ~ chi2_4
+        double c = k.mcdConsistency(m.md, CHI2_4_MEDIAN);
+        if (c > 0) k.mcdScale(m.cov, m.invCov, m.md, c);
+
+        // Reweighting: refit on every sample within the 97.5% chi2_4 bound.
+        // The h-subset estimate alone is noisy (h ~ n/2), the refit recovers
+        // most of the efficiency of the plain window model.
+        std::vector<int> inliers;
+        for (int i = 0; i < n; i++) {
+            if (m.md[i] <= MD_975) inliers.push_back(i);
+        }
+        Model refit;
+        if ((int)inliers.size() >= h && fit(k, X, inliers, refit)) {
+            // Truncation at the 97.5% bound shrinks the covariance by P(chi2_6 <= bound) / 0.975
+            std::vector<double> noMd;
+            k.mcdScale(refit.cov, refit.invCov, noMd, REWEIGHT_CONSISTENCY);
+            for (int i = 0; i < n; i++) m.md[i] = k.mahalanobis(X[i], refit.mean, refit.invCov);
+            m.mean = refit.mean;
+            m.cov = refit.cov;
+            m.invCov = refit.invCov;
+        }
+        return m;
+    }
+
+  private:
+    static bool fit(const DetectorMath::Kernels& k, const DetectorMath::Matrix& X,
+                    const std::vector<int>& H, Model& m) {
+        DetectorMath::Matrix sub;
+        sub.reserve(H.size());
+        for (int i : H) sub.push_back(X[i]);
+        m.mean = k.mean(sub);
+        m.cov = k.covariance(sub, m.mean);
+        m.invCov.assign(4, std::vector<double>(4));
+        m.ok = k.invert4x4(m.cov, m.invCov);
+        return m.ok;
+    }
+
+    // Indices of the h smallest values, ascending index order
+    static std::vector<int> smallest(const std::vector<double>& values, int h) {
+        std::vector<int> idx(values.size());
+        for (size_t i = 0; i < idx.size(); i++) idx[i] = i;
+        std::nth_element(idx.begin(), idx.begin() + (h - 1), idx.end(),
+                         [&](int a, int b) { return values[a] < values[b]; });
+        idx.resize(h);
+        std::sort(idx.begin(), idx.end());
+        return idx;
+    }
+};
+
+#endif
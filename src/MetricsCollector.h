@@ -7,8 +7,9 @@
 #define __ODAMD_METRICSCOLLECTOR_H_
 
 #include <omnetpp.h>
-#include <fstream>
 #include <iomanip>
+#include "MetricsWriter.h"
+#include "RollingMetrics.h"
 
 using namespace omnetpp;
 
@@ -20,10 +21,12 @@ class MetricsCollector {
     int trueNegatives;   // Correctly identified normal data
     int falseNegatives;  // Outliers missed (not detected)
 
-    // Thời gian của các mẫu
-    std::vector<simtime_t> logTimes;
-    std::vector<double> logDA;
-    std::vector<double> logFAR;
+    // Time series of DA/FAR and cumulative TP/FP, streamed to the metrics file
+    MetricsWriter log;
+
+    // Rolling DA/FAR over the last K decisions / last T seconds (off by default)
+    RollingCount lastDecisions;
+    RollingTime lastInterval;
 
   public:
     MetricsCollector() {
@@ -35,11 +38,6 @@ class MetricsCollector {
         falsePositives = 0;
         trueNegatives = 0;
         falseNegatives = 0;
-        logTimes.clear();
-        logDA.clear();
-        logFAR.clear();
-        logTP.clear();
-        logFP.clear();
     }
 
     // Record a detection result
@@ -53,8 +51,20 @@ class MetricsCollector {
         } else if (actualOutlier && !detectedAsOutlier) {
             falseNegatives++;
         }
+        ConfusionCounts::Outcome o = ConfusionCounts::outcome(actualOutlier, detectedAsOutlier);
+        lastDecisions.add(o);
+        lastInterval.add(simTime().dbl(), o);
+    }
+
+    // Call before openLog(): the enabled windows become extra log columns
+    void setRollingWindows(size_t decisions, double interval, int buckets) {
+        lastDecisions.setCapacity(decisions);
+        lastInterval.setInterval(interval, buckets);
     }
 
+    const ConfusionCounts& getLastDecisions() const { return lastDecisions.get(); }
+    const ConfusionCounts& getLastInterval(simtime_t now) { return lastInterval.get(now.dbl()); }
+
     // Detection Accuracy = TP / (TP + FN)
     double getDetectionAccuracy() const {
         int denominator = truePositives + falseNegatives;
@@ -76,18 +86,62 @@ class MetricsCollector {
         return (double)truePositives / denominator;
     }
 
+    // Start the time series file (truncated); false if it cannot be opened
+    bool openLog(const std::string& filename, MetricsWriter::Format format, size_t chunkRows) {
+        std::vector<std::string> rolling;
+        if (lastDecisions.isEnabled()) {
+            rolling.push_back("DALastK");
+            rolling.push_back("FARLastK");
+        }
+        if (lastInterval.isEnabled()) {
+            rolling.push_back("DALastT");
+            rolling.push_back("FARLastT");
+        }
+        return log.open(filename, format, chunkRows, rolling);
+    }
+
     // Log current metrics at a specific time
+    // (with cumulative counts for paper-style graphs, then the rolling windows)
     void logMetrics(simtime_t time) {
-        logTimes.push_back(time);
-        logDA.push_back(getDetectionAccuracy());
-        logFAR.push_back(getFalseAlarmRate());
-        // Also log cumulative counts for paper-style graphs
-        logTP.push_back(truePositives);
-        logFP.push_back(falsePositives);
+        double rolling[4];
+        int n = 0;
+        if (lastDecisions.isEnabled()) {
+            rolling[n++] = lastDecisions.get().detectionAccuracy();
+            rolling[n++] = lastDecisions.get().falseAlarmRate();
+        }
+        if (lastInterval.isEnabled()) {
+            const ConfusionCounts& c = lastInterval.get(time.dbl());
+            rolling[n++] = c.detectionAccuracy();
+            rolling[n++] = c.falseAlarmRate();
+        }
+        log.append(time.dbl(), getDetectionAccuracy(), getFalseAlarmRate(),
+                   truePositives, falsePositives, rolling);
+    }
+
+    // Counts and rolling windows (not the log file) for a checkpoint
+    void save(CheckpointWriter& out) const {
+        out.put(truePositives);
+        out.put(falsePositives);
+        out.put(trueNegatives);
+        out.put(falseNegatives);
+        lastDecisions.save(out);
+        lastInterval.save(out);
+    }
+
+    // After setRollingWindows(): a window configured differently starts empty
+    void load(CheckpointReader& in) {
+        in.get(truePositives);
+        in.get(falsePositives);
+        in.get(trueNegatives);
+        in.get(falseNegatives);
+        lastDecisions.load(in);
+        lastInterval.load(in);
+    }
+
+    // Write the last partial chunk and close the file
+    void closeLog() {
+        log.close();
     }
-    
-    std::vector<int> logTP;   // Cumulative TP over time
-    std::vector<int> logFP;   // Cumulative FP over time
 
     // Get statistics
     int getTP() const { return truePositives; }
@@ -98,24 +152,6 @@ class MetricsCollector {
     int getTotalOutliersDetected() const { return truePositives + falsePositives; }
     int getActualOutliers() const { return truePositives + falseNegatives; }
 
-    // Export metrics to CSV file (with cumulative data for paper-style graphs)
-    void exportToCSV(const std::string& filename) const {
-        std::ofstream file(filename);
-        if (!file.is_open()) return;
-
-        // Header: Time, DA%, FAR%, Cumulative TP, Cumulative FP
-        file << "Time,DA,FAR,CumulativeTP,CumulativeFP\n";
-        for (size_t i = 0; i < logTimes.size(); i++) {
-            file << std::fixed << std::setprecision(2) << logTimes[i].dbl()
-                 << "," << std::setprecision(4) << logDA[i]
-                 << "," << logFAR[i]
-                 << "," << logTP[i]
-                 << "," << logFP[i] << "\n";
-        }
-
-        file.close();
-    }
-
     // Print summary
     void printSummary() const {
         EV << "========================================\n";
@@ -0,0 +1,152 @@
+//
+// Streaming writer for the metrics time series (Time, DA, FAR, cumulative TP/FP)
+// Rows are buffered in a fixed-size chunk and appended to the file whenever
+// the chunk is full, so memory stays constant over the run and a crash loses
+// at most one chunk. Two formats:
+//   csv       Time,DA,FAR,CumulativeTP,CumulativeFP (as before), then the
+//             optional extra columns (e.g. rolling DA/FAR)
+//   columnar  binary, one column after the other per chunk; decoded by
+//             simulations/metrics_reader.py
+//
+// Columnar layout (native little-endian):
+//   char[4]  magic "ODMC"
+//   uint32   version (1)
+//   uint32   schema length in bytes
+//   char[]   schema "Time:f8,DA:f8,FAR:f8,CumulativeTP:i4,CumulativeFP:i4"
+//            followed by ",<name>:f8" per extra column
+//   chunks:  uint32 rows, then each column as rows values
+// There is no footer: a reader stops at the first incomplete chunk.
+//
+
+#ifndef __ODAMD_METRICSWRITER_H_
+#define __ODAMD_METRICSWRITER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class MetricsWriter {
+  public:
+    enum Format { CSV, COLUMNAR };
+
+  private:
+    FILE *file;
+    Format format;
+    size_t chunkRows;
+    uint64_t rowsWritten;
+
+    // Current chunk, one vector per column (capacity chunkRows)
+    std::vector<double> time, da, far;
+    std::vector<int32_t> tp, fp;
+    std::vector<std::vector<double>> extra;
+
+    template <typename T>
+    void writeColumn(const std::vector<T>& column) {
+        fwrite(column.data(), sizeof(T), column.size(), file);
+    }
+
+  public:
+    MetricsWriter() : file(nullptr), format(CSV), chunkRows(256), rowsWritten(0) {}
+    ~MetricsWriter() { close(); }
+
+    MetricsWriter(const MetricsWriter&) = delete;
+    MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+    static bool parseFormat(const std::string& name, Format& out) {
+        if (name == "csv") out = CSV;
+        else if (name == "columnar") out = COLUMNAR;
+        else return false;
+        return true;
+    }
+
+    static const char *extension(Format f) { return (f == CSV) ? ".csv" : ".odm"; }
+
+    // Truncates the file and writes the header; false if it cannot be opened
+    bool open(const std::string& filename, Format f, size_t rowsPerChunk,
+              const std::vector<std::string>& extraColumns = std::vector<std::string>()) {
+        close();
+        file = fopen(filename.c_str(), (f == CSV) ? "w" : "wb");
+        if (file == nullptr) return false;
+        format = f;
+        chunkRows = (rowsPerChunk > 0) ? rowsPerChunk : 1;
+        rowsWritten = 0;
+        time.reserve(chunkRows);
+        da.reserve(chunkRows);
+        far.reserve(chunkRows);
+        tp.reserve(chunkRows);
+        fp.reserve(chunkRows);
+        extra.assign(extraColumns.size(), std::vector<double>());
+        for (auto& column : extra) column.reserve(chunkRows);
+
+        if (format == CSV) {
+            std::string header = "Time,DA,FAR,CumulativeTP,CumulativeFP";
+            for (const auto& name : extraColumns) header += "," + name;
+            fputs((header + "\n").c_str(), file);
+        } else {
+            std::string schema = "Time:f8,DA:f8,FAR:f8,CumulativeTP:i4,CumulativeFP:i4";
+            for (const auto& name : extraColumns) schema += "," + name + ":f8";
+            uint32_t header[3] = {0, 1, (uint32_t)schema.size()};
+            memcpy(&header[0], "ODMC", 4);
+            fwrite(header, sizeof(header), 1, file);
+            fwrite(schema.data(), 1, schema.size(), file);
+        }
+        fflush(file);
+        return true;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t getRows() const { return rowsWritten + time.size(); }
+
+    // extraValues: one value per extra column given to open()
+    void append(double t, double detectionAccuracy, double falseAlarmRate, int cumTP, int cumFP,
+                const double *extraValues = nullptr) {
+        if (file == nullptr) return;
+        time.push_back(t);
+        da.push_back(detectionAccuracy);
+        far.push_back(falseAlarmRate);
+        tp.push_back(cumTP);
+        fp.push_back(cumFP);
+        for (size_t c = 0; c < extra.size(); c++) extra[c].push_back(extraValues[c]);
+        if (time.size() >= chunkRows) flush();
+    }
+
+    // Write the buffered chunk and hand it to the OS
+    void flush() {
+        if (file == nullptr || time.empty()) return;
+        if (format == CSV) {
+            for (size_t i = 0; i < time.size(); i++) {
+                fprintf(file, "%.2f,%.4f,%.4f,%d,%d", time[i], da[i], far[i], tp[i], fp[i]);
+                for (const auto& column : extra) fprintf(file, ",%.4f", column[i]);
+                fputc('\n', file);
+            }
+        } else {
+            uint32_t rows = time.size();
+            fwrite(&rows, sizeof(rows), 1, file);
+            writeColumn(time);
+            writeColumn(da);
+            writeColumn(far);
+            writeColumn(tp);
+            writeColumn(fp);
+            for (const auto& column : extra) writeColumn(column);
+        }
+        fflush(file);
+        rowsWritten += time.size();
+        time.clear();
+        da.clear();
+        far.clear();
+        tp.clear();
+        fp.clear();
+        for (auto& column : extra) column.clear();
+    }
+
+    void close() {
+        if (file == nullptr) return;
+        flush();
+        fclose(file);
+        file = nullptr;
+    }
+};
+
+#endif
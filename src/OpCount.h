@@ -0,0 +1,102 @@
+//
+// Floating-point operation counting for the detector kernels
+// Counted<T> wraps a number and tallies every add/sub, mul, div and sqrt
+// into opTally(). Kernels instantiated with plain double add the same
+// counts analytically instead (see DetectorMath.h), so release builds pay
+// nothing; build with make COUNT_OPS=1 (-DODAMD_COUNT_OPS) to measure.
+//
+
+#ifndef __ODAMD_OPCOUNT_H_
+#define __ODAMD_OPCOUNT_H_
+
+#include <cmath>
+#include <type_traits>
+
+struct OpCounts {
+    long adds;      // Additions and subtractions
+    long muls;
+    long divs;
+    long sqrts;
+
+    OpCounts() : adds(0), muls(0), divs(0), sqrts(0) {}
+    OpCounts(long a, long m, long d, long s) : adds(a), muls(m), divs(d), sqrts(s) {}
+
+    void reset() { adds = muls = divs = sqrts = 0; }
+    long flops() const { return adds + muls + divs + sqrts; }
+
+    OpCounts& operator+=(const OpCounts& o) {
+        adds += o.adds; muls += o.muls; divs += o.divs; sqrts += o.sqrts;
+        return *this;
+    }
+};
+
+// Operations since the last takeOps() (the simulation is single-threaded)
+inline OpCounts& opTally()
+{
+    static OpCounts tally;
+    return tally;
+}
+
+inline OpCounts takeOps()
+{
+    OpCounts ops = opTally();
+    opTally().reset();
+    return ops;
+}
+
+// Operations inside the scope are discarded; the tally before it is kept
+// (simulation-side shadow work that must not be charged to the node)
+class UncountedOps {
+  private:
+    OpCounts pending;
+
+  public:
+    UncountedOps() : pending(takeOps()) {}
+    ~UncountedOps() { opTally() = pending; }
+
+    UncountedOps(const UncountedOps&) = delete;
+    UncountedOps& operator=(const UncountedOps&) = delete;
+};
+
+template <typename T>
+class Counted {
+  private:
+    T v;
+
+  public:
+    Counted() : v() {}
+    Counted(T x) : v(x) {}
+    explicit operator T() const { return v; }
+
+    friend Counted operator+(Counted a, Counted b) { opTally().adds++; return a.v + b.v; }
+    friend Counted operator-(Counted a, Counted b) { opTally().adds++; return a.v - b.v; }
+    friend Counted operator*(Counted a, Counted b) { opTally().muls++; return a.v * b.v; }
+    friend Counted operator/(Counted a, Counted b) { opTally().divs++; return a.v / b.v; }
+    friend Counted operator-(Counted a) { return -a.v; }  // Sign flip, not counted
+
+    Counted& operator+=(Counted o) { return *this = *this + o; }
+    Counted& operator-=(Counted o) { return *this = *this - o; }
+    Counted& operator*=(Counted o) { return *this = *this * o; }
+    Counted& operator/=(Counted o) { return *this = *this / o; }
+
+    // Comparisons and abs are not floating-point arithmetic here
+    friend bool operator<(Counted a, Counted b) { return a.v < b.v; }
+    friend bool operator>(Counted a, Counted b) { return a.v > b.v; }
+    friend bool operator<=(Counted a, Counted b) { return a.v <= b.v; }
+    friend bool operator>=(Counted a, Counted b) { return a.v >= b.v; }
+
+    friend Counted sqrt(Counted a) { opTally().sqrts++; return std::sqrt(a.v); }
+    friend Counted abs(Counted a) { return std::abs(a.v); }
+};
+
+template <typename T> struct IsCounted : std::false_type {};
+template <typename T> struct IsCounted<Counted<T>> : std::true_type {};
+
+// Analytic counts for kernels running on uncounted types
+template <typename T>
+inline void countOps(long adds, long muls, long divs, long sqrts)
+{
+    if (!IsCounted<T>::value) opTally() += OpCounts(adds, muls, divs, sqrts);
+}
+
+#endif
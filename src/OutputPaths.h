@@ -0,0 +1,47 @@
+//
+// Run-unique output paths for files written by the simulation modules
+// <resultdir>/<configname>-<runnumber>-<name>, so concurrent runs (parameter
+// sweeps, parallel partitions) never overwrite each other's files
+//
+
+#ifndef __ODAMD_OUTPUTPATHS_H_
+#define __ODAMD_OUTPUTPATHS_H_
+
+#include <omnetpp.h>
+#include <string>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+using namespace omnetpp;
+
+inline void makeOutputDirectory(const std::string& dir) {
+    // Create each path component in turn (existing ones are left alone)
+    for (size_t pos = dir.find('/', 1); ; pos = dir.find('/', pos + 1)) {
+        std::string part = dir.substr(0, pos);
+#ifdef _WIN32
+        _mkdir(part.c_str());
+#else
+        mkdir(part.c_str(), 0755);
+#endif
+        if (pos == std::string::npos) break;
+    }
+}
+
+inline std::string runOutputPath(const std::string& name) {
+    cConfigurationEx *cfg = getEnvir()->getConfigEx();
+    const char *resultDir = cfg->getVariable(CFGVAR_RESULTDIR);
+    std::string dir = (resultDir && *resultDir) ? resultDir : "results";
+    makeOutputDirectory(dir);
+
+    return dir + "/" + cfg->getVariable(CFGVAR_CONFIGNAME) + "-"
+           + cfg->getVariable(CFGVAR_RUNNUMBER) + "-" + name;
+}
+
+// Checkpoint file of a module: <dir>/<module full path>.ckpt
+inline std::string checkpointPath(const std::string& dir, const cModule *module) {
+    return dir + "/" + module->getFullPath() + ".ckpt";
+}
+
+#endif
@@ -0,0 +1,118 @@
+//
+// Compact sensor payload encoding (payloadEncoding = "delta")
+// Each reading (T, H, L, V) is quantized to the sensor resolution, the
+// first reading of a mote is sent absolute and every later one as the
+// difference to the previous reading of the same mote, and each value
+// is packed as a zigzag varint (7 bits per byte). Flat readings shrink
+// to one byte per feature. Every refreshInterval-th packet starts with an
+// absolute record again, so a decoder that lost the reference (dropped or
+// undecodable packet) resynchronises.
+//
+// Packet layout:
+//   96-bit header (source, request, sequence number: not in the payload)
+//   uint8    flags (bit 0: first record is absolute)
+//   records  4 varints each, oldest first
+//
+
+#ifndef __ODAMD_PAYLOADCODEC_H_
+#define __ODAMD_PAYLOADCODEC_H_
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class PayloadCodec {
+  public:
+    static constexpr int FEATURES = 4;
+    static constexpr int HEADER_BITS = 96;
+    static constexpr uint8_t FLAG_ABSOLUTE = 0x01;
+
+    // Sensor resolution of T (degC), H (%), L (lux), V (V)
+    static double step(int feature) {
+        static constexpr double STEPS[FEATURES] = {0.01, 0.01, 0.1, 0.001};
+        return STEPS[feature];
+    }
+
+    // Previous quantized reading of one mote (encoder at the sensor,
+    // decoder per source at the CH)
+    struct State {
+        bool valid = false;
+        int64_t prev[FEATURES] = {0, 0, 0, 0};
+        int packetsSinceAbsolute = 0;   // Encoder only
+    };
+
+    static int packetBits(size_t payloadBytes) {
+        return HEADER_BITS + 8 * (int)payloadBytes;
+    }
+
+    // Readings (T, H, L, V each) -> payload bytes; the first record is
+    // absolute for a fresh state and every refreshInterval packets (0 = never)
+    static std::vector<uint8_t> encode(State& state, const std::vector<std::vector<double>>& readings,
+                                       int refreshInterval) {
+        std::vector<uint8_t> out;
+        bool absolute = !state.valid || (refreshInterval > 0 && state.packetsSinceAbsolute >= refreshInterval);
+        if (absolute) state.packetsSinceAbsolute = 0;
+        state.packetsSinceAbsolute++;
+        out.push_back(absolute ? FLAG_ABSOLUTE : 0);
+        for (const auto& x : readings) {
+            for (int j = 0; j < FEATURES; j++) {
+                int64_t q = (int64_t)std::llround(x[j] / step(j));
+                putVarint(out, absolute ? q : q - state.prev[j]);
+                state.prev[j] = q;
+            }
+            absolute = false;
+            state.valid = true;
+        }
+        return out;
+    }
+
+    // Payload bytes -> readings (dequantized); false on a truncated payload
+    static bool decode(State& state, const std::vector<uint8_t>& in, std::vector<std::vector<double>>& readings) {
+        readings.clear();
+        if (in.empty()) return false;
+        bool absolute = (in[0] & FLAG_ABSOLUTE) != 0;
+        if (!absolute && !state.valid) return false;  // Delta without a reference
+
+        size_t pos = 1;
+        while (pos < in.size()) {
+            std::vector<double> x(FEATURES);
+            for (int j = 0; j < FEATURES; j++) {
+                int64_t v;
+                if (!getVarint(in, pos, v)) return false;
+                int64_t q = absolute ? v : state.prev[j] + v;
+                state.prev[j] = q;
+                x[j] = q * step(j);
+            }
+            absolute = false;
+            state.valid = true;
+            readings.push_back(x);
+        }
+        return true;
+    }
+
+  private:
+    static void putVarint(std::vector<uint8_t>& out, int64_t value) {
+        uint64_t zz = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);  // Zigzag
+        while (zz >= 0x80) {
+            out.push_back((uint8_t)(zz | 0x80));
+            zz >>= 7;
+        }
+        out.push_back((uint8_t)zz);
+    }
+
+    static bool getVarint(const std::vector<uint8_t>& in, size_t& pos, int64_t& value) {
+        uint64_t zz = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= in.size()) return false;
+            uint8_t b = in[pos++];
+            zz |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                value = (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,178 @@
+//
+// Rolling confusion matrix over the most recent decisions
+// Cumulative DA/FAR barely move late in a long run; these counters only
+// see the last K decisions or the last T seconds. Both keep running
+// totals and a ring of what has to be taken out again, so every update
+// and query is O(1):
+//   RollingCount  ring of the last K outcomes (one byte each)
+//   RollingTime   ring of B time buckets of T/B seconds each; the window
+//                 covers the current bucket and the B-1 before it, i.e.
+//                 between T - T/B and T seconds; times must not decrease
+//                 (simulation time)
+//
+
+#ifndef __ODAMD_ROLLINGMETRICS_H_
+#define __ODAMD_ROLLINGMETRICS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+
+// Confusion matrix counts with the DA/FAR definitions of MetricsCollector
+struct ConfusionCounts {
+    enum Outcome { TP, FP, TN, FN };
+    long n[4] = {0, 0, 0, 0};
+
+    static Outcome outcome(bool actualOutlier, bool detectedAsOutlier) {
+        if (actualOutlier) return detectedAsOutlier ? TP : FN;
+        return detectedAsOutlier ? FP : TN;
+    }
+
+    double detectionAccuracy() const {
+        long d = n[TP] + n[FN];
+        return (d == 0) ? 0.0 : (double)n[TP] / d;
+    }
+
+    double falseAlarmRate() const {
+        long d = n[FP] + n[TN];
+        return (d == 0) ? 0.0 : (double)n[FP] / d;
+    }
+};
+
+class RollingCount {
+  private:
+    std::vector<uint8_t> ring;
+    size_t next;
+    size_t filled;
+    ConfusionCounts counts;
+
+  public:
+    RollingCount() : next(0), filled(0) {}
+
+    // capacity 0 disables the window
+    void setCapacity(size_t k) {
+        ring.assign(k, 0);
+        next = 0;
+        filled = 0;
+        counts = ConfusionCounts();
+    }
+
+    bool isEnabled() const { return !ring.empty(); }
+    const ConfusionCounts& get() const { return counts; }
+
+    void add(ConfusionCounts::Outcome o) {
+        if (ring.empty()) return;
+        if (filled == ring.size()) counts.n[ring[next]]--;  // Evict the oldest
+        else filled++;
+        ring[next] = (uint8_t)o;
+        counts.n[o]++;
+        if (++next == ring.size()) next = 0;
+    }
+
+    void save(CheckpointWriter& out) const {
+        out.putVector(ring);
+        out.put((uint64_t)next);
+        out.put((uint64_t)filled);
+        out.put(counts);
+    }
+
+    // Kept only if the capacity is unchanged (else the window starts empty)
+    void load(CheckpointReader& in) {
+        std::vector<uint8_t> r;
+        uint64_t n = 0, f = 0;
+        ConfusionCounts c;
+        in.getVector(r);
+        in.get(n);
+        in.get(f);
+        in.get(c);
+        if (!in.good() || r.size() != ring.size() || n >= std::max<size_t>(r.size(), 1) || f > r.size()) return;
+        ring.swap(r);
+        next = n;
+        filled = f;
+        counts = c;
+    }
+};
+
+class RollingTime {
+  private:
+    struct Bucket {
+        long n[4];
+    };
+    std::vector<Bucket> buckets;
+    double width;               // Seconds per bucket
+    int64_t headEpoch;          // Newest bucket epoch seen
+    ConfusionCounts counts;
+
+    // Retire every bucket that fell out of the window up to epoch.
+    // At most B buckets per call; each bucket is retired once per lap.
+    void advance(int64_t epoch) {
+        if (epoch <= headEpoch) return;
+        int64_t size = buckets.size();
+        int64_t from = (epoch - headEpoch > size) ? epoch - size + 1 : headEpoch + 1;
+        for (int64_t e = from; e <= epoch; e++) {
+            Bucket& b = buckets[e % size];
+            for (int j = 0; j < 4; j++) {
+                counts.n[j] -= b.n[j];
+                b.n[j] = 0;
+            }
+        }
+        headEpoch = epoch;
+    }
+
+  public:
+    RollingTime() : width(0), headEpoch(0) {}
+
+    // interval <= 0 disables the window
+    void setInterval(double interval, int numBuckets) {
+        buckets.clear();
+        counts = ConfusionCounts();
+        headEpoch = 0;
+        if (interval <= 0 || numBuckets <= 0) return;
+        width = interval / numBuckets;
+        buckets.assign(numBuckets, Bucket{{0, 0, 0, 0}});
+    }
+
+    bool isEnabled() const { return !buckets.empty(); }
+
+    void add(double time, ConfusionCounts::Outcome o) {
+        if (buckets.empty()) return;
+        int64_t epoch = (int64_t)std::floor(time / width);
+        advance(epoch);
+        if (epoch < headEpoch - (int64_t)buckets.size() + 1) return;  // Older than the window
+        buckets[epoch % (int64_t)buckets.size()].n[o]++;
+        counts.n[o]++;
+    }
+
+    // Counts of the window ending at time
+    const ConfusionCounts& get(double time) {
+        if (!buckets.empty()) advance((int64_t)std::floor(time / width));
+        return counts;
+    }
+
+    void save(CheckpointWriter& out) const {
+        out.putVector(buckets);
+        out.put(width);
+        out.put(headEpoch);
+        out.put(counts);
+    }
+
+    // Kept only if interval and bucket count are unchanged
+    void load(CheckpointReader& in) {
+        std::vector<Bucket> b;
+        double w = 0;
+        int64_t head = 0;
+        ConfusionCounts c;
+        in.getVector(b);
+        in.get(w);
+        in.get(head);
+        in.get(c);
+        if (!in.good() || b.size() != buckets.size() || w != width) return;
+        buckets.swap(b);
+        headEpoch = head;
+        counts = c;
+    }
+};
+
+#endif
@@ -10,12 +10,16 @@
 
 #include "SensorNode.h"
 #include "messages_m.h"
+#include "ArrivalTrace.h"
+#include "OutputPaths.h"
+#include <algorithm>
 
 Define_Module(SensorNode);
 
 // Static member initialization
 IntelLabData* SensorNode::sharedData = nullptr;
 bool SensorNode::dataLoaded = false;
+int SensorNode::instanceCount = 0;
 
 void SensorNode::loadSharedData()
 {
@@ -29,8 +33,8 @@ void SensorNode::loadSharedData()
         dataFile = "../data.txt";
     }
 
-    // Mote IDs to filter (nodes 36, 37, 38 theo bài báo)
-    std::vector<int> moteIds = {36, 37, 38};
+    // Mote IDs to filter (nodes 36, 37, 38 theo bài báo, or all motes if empty)
+    std::vector<int> moteIds = cStringTokenizer(par("dataMotes").stringValue()).asIntVector();
 
     // Date range from paper: 2004-03-11 to 2004-03-14
     std::string startDate = "2004-03-11";
@@ -41,9 +45,9 @@ void SensorNode::loadSharedData()
     if (loaded) {
         EV << "=== INTEL LAB DATA LOADED ===\n";
         EV << "Total readings: " << sharedData->getTotalReadings() << "\n";
-        EV << "Node 36: " << sharedData->getReadingsCount(36) << " readings\n";
-        EV << "Node 37: " << sharedData->getReadingsCount(37) << " readings\n";
-        EV << "Node 38: " << sharedData->getReadingsCount(38) << " readings\n";
+        for (int id : sharedData->getMoteIds()) {
+            EV << "Node " << id << ": " << sharedData->getReadingsCount(id) << " readings\n";
+        }
 
         // Inject exactly 1000 STRONG outliers as per paper
         sharedData->injectExactOutliers(1000, 5.0);  // multiplier=5.0 for strong outliers
@@ -63,14 +67,43 @@ void SensorNode::initialize()
     nodeId = par("nodeId");
 
     // Map node index to real mote ID
+    // Explicit moteId parameter (multi-cluster topologies), otherwise
     // sensor[0] -> mote 36, sensor[1] -> mote 37, sensor[2] -> mote 38
-    int index = getIndex();
-    if (index == 0) realMoteId = 36;
-    else if (index == 1) realMoteId = 37;
-    else realMoteId = 38;
+    realMoteId = par("moteId");
+    if (realMoteId < 0) {
+        int index = getIndex();
+        if (index == 0) realMoteId = 36;
+        else if (index == 1) realMoteId = 37;
+        else realMoteId = 38;
+    }
+    instanceCount++;
 
     // Configuration
     useRealData = par("useRealData").boolValue();
+    eventsHandled = 0;
+    seqNo = 0;
+
+    // Batched responses (local sensing between requests)
+    batchSize = par("batchSize");
+    senseInterval = par("senseInterval").doubleValue();
+    if (senseInterval <= 0) senseInterval = 1.0;
+    senseBuffer.clear();
+    readingsOverwritten = 0;
+    senseTimer = nullptr;
+    if (batchSize > 1) {
+        senseTimer = new cMessage("senseTimer");
+        scheduleAt(simTime() + senseInterval, senseTimer);
+    }
+
+    // Payload encoding
+    std::string encoding = par("payloadEncoding").stdstringValue();
+    if (encoding != "raw" && encoding != "delta")
+        throw cRuntimeError("Unknown payloadEncoding '%s' (raw, delta)", encoding.c_str());
+    deltaEncoding = (encoding == "delta");
+    payloadRefreshInterval = par("payloadRefreshInterval");
+    encoder = PayloadCodec::State();
+    payloadBitsSent = 0;
+    readingsSent = 0;
 
     // Load shared data (only first sensor does this)
     if (useRealData) {
@@ -80,6 +113,12 @@ void SensorNode::initialize()
     // Initialize energy (2J theo Heinzelman)
     energy = EnergyModel(2.0);
 
+    // Resume from a checkpoint written by this node's ClusterHead
+    std::string restoreDir = par("restoreDir").stdstringValue();
+    if (!restoreDir.empty()) {
+        restoreCheckpoint(checkpointPath(restoreDir, this));
+    }
+
     EV << "SensorNode " << nodeId << " (MoteID=" << realMoteId << ") initialized.\n";
     EV << "  [Request-Response mode: waiting for requests from CH]\n";
 }
@@ -91,6 +130,21 @@ void SensorNode::initialize()
 // =============================================================================
 void SensorNode::handleMessage(cMessage *msg)
 {
+    eventsHandled++;
+
+    // Batched mode: local sensing between requests
+    if (msg == senseTimer) {
+        if (energy.isAlive()) {
+            senseBuffer.push_back(senseReading());
+            if ((int)senseBuffer.size() > batchSize) {
+                senseBuffer.pop_front();  // Keep the newest batchSize readings
+                readingsOverwritten++;
+            }
+        }
+        scheduleAt(simTime() + senseInterval, senseTimer);
+        return;
+    }
+
     // Check if this is a request from CH
     RequestMsg *req = dynamic_cast<RequestMsg *>(msg);
     
@@ -107,58 +161,251 @@ void SensorNode::handleMessage(cMessage *msg)
         // Energy consumption for receiving request
         energy.receive(64);  // 64 bits = 8 bytes control packet
 
-        // 1. Tạo gói tin SensorMsg phản hồi
-        SensorMsg *sMsg = new SensorMsg("SensorData");
-        sMsg->setSourceId(realMoteId);  // Use real mote ID
+        if (batchSize > 1) {
+            respondBatch(req);
+        } else {
+            respondSingle(req);
+        }
+
+        // Delete the request message
+        delete msg;
+    }
+    else {
+        // Unknown message type
+        EV << "SensorNode " << realMoteId << " received unknown message type\n";
+        delete msg;
+    }
+}
 
-        bool isOutlier = false;
+// Sense one reading (Intel Lab replay or synthetic)
+SampleRecord SensorNode::senseReading()
+{
+    SampleRecord r;
+    r.isOutlier = false;
 
-        if (useRealData && sharedData != nullptr) {
-            // 2a. Lấy dữ liệu thực từ Intel Lab
-            SensorReading reading = sharedData->getNextReading(realMoteId);
+    if (useRealData && sharedData != nullptr) {
+        // Lấy dữ liệu thực từ Intel Lab
+        SensorReading reading = sharedData->getNextReading(realMoteId);
 
-            sMsg->setTemperature(reading.temperature);
-            sMsg->setHumidity(reading.humidity);
-            sMsg->setLight(reading.light);
-            sMsg->setVoltage(reading.voltage);
-            isOutlier = reading.isOutlier;
+        r.temperature = reading.temperature;
+        r.humidity = reading.humidity;
+        r.light = reading.light;
+        r.voltage = reading.voltage;
+        r.isOutlier = reading.isOutlier;
 
-        } else {
-            // 2b. Dữ liệu giả lập (fallback)
-            sMsg->setTemperature(normal(23, 2));
-            sMsg->setHumidity(normal(35, 5));
-            sMsg->setLight(normal(400, 100));
-            sMsg->setVoltage(normal(2.5, 0.1));
-
-            // 5% chance of outlier
-            if (uniform(0, 1) < 0.05) {
-                sMsg->setTemperature(normal(60, 10));  // Abnormal temp
-                isOutlier = true;
-            }
+    } else {
+        // Dữ liệu giả lập (fallback)
+        r.temperature = normal(23, 2);
+        r.humidity = normal(35, 5);
+        r.light = normal(400, 100);
+        r.voltage = normal(2.5, 0.1);
+
+        // 5% chance of outlier
+        if (uniform(0, 1) < 0.05) {
+            r.temperature = normal(60, 10);  // Abnormal temp
+            r.isOutlier = true;
         }
+    }
 
-        sMsg->setIsOutlier(isOutlier);
+    // Latency tracking: sensing time and sequence number
+    r.senseTime = simTime();
+    r.seqNo = seqNo++;
 
-        if (isOutlier) {
-            EV << "SensorNode " << realMoteId << " responding with OUTLIER data! "
-               << "T=" << sMsg->getTemperature() << "\n";
-        }
+    if (r.isOutlier) {
+        EV_DEBUG << "SensorNode " << realMoteId << " sensed OUTLIER data! "
+           << "T=" << r.temperature << "\n";
+    }
+    return r;
+}
 
-        // 3. Consume energy for transmission
-        // Packet size: 32 bytes = 256 bits, distance ~20m to CH
-        energy.transmit(256, 20.0);
+// One SensorMsg per request, sensed on request (Algorithm 1)
+void SensorNode::respondSingle(RequestMsg *req)
+{
+    SampleRecord r = senseReading();
+    if (deltaEncoding) {
+        respondEncoded(req, std::vector<SampleRecord>(1, r));
+        return;
+    }
 
-        // 4. Gửi phản hồi sang Cluster Head
-        send(sMsg, "out");
+    // 1. Tạo gói tin SensorMsg phản hồi
+    SensorMsg *sMsg = new SensorMsg("SensorData");
+    sMsg->setSourceId(realMoteId);  // Use real mote ID
+    sMsg->setTemperature(r.temperature);
+    sMsg->setHumidity(r.humidity);
+    sMsg->setLight(r.light);
+    sMsg->setVoltage(r.voltage);
+    sMsg->setIsOutlier(r.isOutlier);
+    sMsg->setSenseTime(r.senseTime);
+    sMsg->setRequestId(req->getRequestId());
+    sMsg->setSeqNo(r.seqNo);
+
+    // 2. Consume energy for transmission
+    // Packet size: 32 bytes = 256 bits, distance ~20m to CH
+    energy.transmit(256, 20.0);
+    payloadBitsSent += 256;
+    readingsSent++;
+
+    // 3. Gửi phản hồi sang Cluster Head
+    send(sMsg, "out");
+}
 
-        // Delete the request message
-        delete msg;
+// Every reading buffered since the previous request in one packet
+void SensorNode::respondBatch(RequestMsg *req)
+{
+    if (senseBuffer.empty()) {
+        senseBuffer.push_back(senseReading());  // Nothing sensed yet: sense now
     }
-    else {
-        // Unknown message type
-        EV << "SensorNode " << realMoteId << " received unknown message type\n";
-        delete msg;
+    if (deltaEncoding) {
+        respondEncoded(req, std::vector<SampleRecord>(senseBuffer.begin(), senseBuffer.end()));
+        senseBuffer.clear();
+        return;
+    }
+
+    SensorBatchMsg *batch = new SensorBatchMsg("SensorBatch");
+    batch->setSourceId(realMoteId);
+    batch->setRequestId(req->getRequestId());
+    batch->setSamplesArraySize(senseBuffer.size());
+    for (size_t i = 0; i < senseBuffer.size(); i++) {
+        batch->setSamples(i, senseBuffer[i]);
+    }
+
+    // Payload: 96-bit header + 160 bits per reading (256 bits for one reading)
+    int bits = 96 + 160 * (int)senseBuffer.size();
+    energy.transmit(bits, 20.0);
+    payloadBitsSent += bits;
+    readingsSent += senseBuffer.size();
+    senseBuffer.clear();
+
+    send(batch, "out");
+}
+
+// Quantized, delta-encoded readings; charged by the encoded size
+void SensorNode::respondEncoded(RequestMsg *req, const std::vector<SampleRecord>& readings)
+{
+    std::vector<std::vector<double>> values;
+    values.reserve(readings.size());
+    for (const SampleRecord& r : readings) {
+        values.push_back({r.temperature, r.humidity, r.light, r.voltage});
+    }
+    std::vector<uint8_t> payload = PayloadCodec::encode(encoder, values, payloadRefreshInterval);
+
+    EncodedSensorMsg *eMsg = new EncodedSensorMsg("SensorEncoded");
+    eMsg->setSourceId(realMoteId);
+    eMsg->setRequestId(req->getRequestId());
+    eMsg->setFirstSeqNo(readings.front().seqNo);
+    eMsg->setPayloadArraySize(payload.size());
+    for (size_t i = 0; i < payload.size(); i++) {
+        eMsg->setPayload(i, payload[i]);
+    }
+    eMsg->setOutlierFlagsArraySize(readings.size());
+    eMsg->setSenseTimesArraySize(readings.size());
+    for (size_t i = 0; i < readings.size(); i++) {
+        eMsg->setOutlierFlags(i, readings[i].isOutlier);
+        eMsg->setSenseTimes(i, readings[i].senseTime);
+    }
+
+    int bits = PayloadCodec::packetBits(payload.size());
+    energy.transmit(bits, 20.0);
+    payloadBitsSent += bits;
+    readingsSent += readings.size();
+
+    send(eMsg, "out");
+}
+
+// =============================================================================
+// CHECKPOINT / RESTORE (written when the ClusterHead checkpoints)
+// Counters, energy, the local sensing buffer and timer, the delta encoder
+// and this mote's read position in the shared Intel Lab data; the data set
+// itself is reloaded (outlier injection is seeded, so it is identical).
+// Synthetic readings (useRealData = false) continue from a fresh RNG state.
+// =============================================================================
+void SensorNode::saveCheckpoint(const std::string& dir)
+{
+    Enter_Method_Silent();
+
+    std::string filename = checkpointPath(dir, this);
+    CheckpointWriter out;
+    if (!out.open(filename, "SensorNode", simTime().raw(), SimTime::getScaleExp()))
+        throw cRuntimeError("Cannot write checkpoint '%s'", filename.c_str());
+
+    out.put(eventsHandled);
+    out.put(seqNo);
+    out.put(energy);
+    out.put((uint64_t)((useRealData && sharedData != nullptr) ? sharedData->getReadIndex(realMoteId) : 0));
+    out.put((int64_t)((senseTimer != nullptr && senseTimer->isScheduled()) ? senseTimer->getArrivalTime().raw() : -1));
+
+    // Buffered readings in the arrival-trace record layout
+    std::vector<ArrivalRecord> buffered;
+    for (const SampleRecord& r : senseBuffer) {
+        ArrivalRecord a;
+        memset(&a, 0, sizeof(a));
+        a.senseTime = r.senseTime.raw();
+        a.temperature = r.temperature;
+        a.humidity = r.humidity;
+        a.light = r.light;
+        a.voltage = r.voltage;
+        a.sourceId = realMoteId;
+        a.seqNo = r.seqNo;
+        a.isOutlier = r.isOutlier;
+        buffered.push_back(a);
     }
+    out.putVector(buffered);
+    out.put(readingsOverwritten);
+    out.put(encoder);
+    out.put(payloadBitsSent);
+    out.put(readingsSent);
+
+    if (!out.close())
+        throw cRuntimeError("Cannot write checkpoint '%s'", filename.c_str());
+}
+
+void SensorNode::restoreCheckpoint(const std::string& filename)
+{
+    CheckpointReader in;
+    if (!in.open(filename, "SensorNode"))
+        throw cRuntimeError("Cannot restore '%s': missing, or not a SensorNode checkpoint of this version",
+                            filename.c_str());
+    simtime_t at = SimTime::fromRaw(in.getTime());
+
+    uint64_t readIndex = 0;
+    int64_t senseAt = -1;
+    in.get(eventsHandled);
+    in.get(seqNo);
+    in.get(energy);
+    in.get(readIndex);
+    in.get(senseAt);
+    if (useRealData && sharedData != nullptr) {
+        sharedData->setReadIndex(realMoteId, readIndex);
+    }
+    if (senseTimer != nullptr) {
+        cancelEvent(senseTimer);
+        scheduleAt(senseAt >= 0 ? SimTime::fromRaw(senseAt) : at + senseInterval, senseTimer);
+    }
+
+    // A smaller batchSize in this run keeps the newest readings
+    std::vector<ArrivalRecord> buffered;
+    in.getVector(buffered);
+    for (const ArrivalRecord& a : buffered) {
+        SampleRecord r;
+        r.temperature = a.temperature;
+        r.humidity = a.humidity;
+        r.light = a.light;
+        r.voltage = a.voltage;
+        r.isOutlier = a.isOutlier != 0;
+        r.senseTime = SimTime::fromRaw(a.senseTime);
+        r.seqNo = a.seqNo;
+        senseBuffer.push_back(r);
+    }
+    while ((int)senseBuffer.size() > std::max(batchSize, 1)) senseBuffer.pop_front();
+    if (batchSize <= 1) senseBuffer.clear();
+    in.get(readingsOverwritten);
+    in.get(encoder);
+    in.get(payloadBitsSent);
+    in.get(readingsSent);
+
+    if (!in.finish())
+        throw cRuntimeError("Checkpoint '%s' is truncated or corrupt", filename.c_str());
+    EV << "SensorNode " << realMoteId << " restored at t=" << at << "\n";
 }
 
 void SensorNode::finish()
@@ -167,8 +414,18 @@ void SensorNode::finish()
        << energy.getConsumedEnergyMJ() << " mJ ("
        << (100 - energy.getEnergyPercentage()) << "% used)\n";
 
+    cancelAndDelete(senseTimer);
+
+    recordScalar("eventsHandled", eventsHandled);
+    recordScalar("energyConsumed", energy.getConsumedEnergyMJ(), "mJ");
+    if (batchSize > 1) {
+        recordScalar("readingsOverwritten", readingsOverwritten);
+    }
+    recordScalar("payloadBitsSent", payloadBitsSent);
+    recordScalar("bitsPerReading", readingsSent > 0 ? (double)payloadBitsSent / readingsSent : 0.0);
+
     // Clean up shared data if this is the last sensor
-    if (getIndex() == 2 && sharedData != nullptr) {
+    if (--instanceCount == 0 && sharedData != nullptr) {
         delete sharedData;
         sharedData = nullptr;
         dataLoaded = false;
@@ -6,8 +6,12 @@
 #define __ODAMD_SENSORNODE_H_
 
 #include <omnetpp.h>
+#include <deque>
+#include "messages_m.h"
 #include "IntelLabData.h"
 #include "EnergyModel.h"
+#include "PayloadCodec.h"
+#include "Checkpoint.h"
 
 using namespace omnetpp;
 
@@ -15,11 +19,12 @@ class SensorNode : public cSimpleModule
 {
   private:
     int nodeId;
-    int realMoteId;          // Mote ID từ Intel Lab (36, 37, 38)
+    int realMoteId;          // Mote ID từ Intel Lab (36, 37, 38 or from moteId parameter)
 
     // Data source
     static IntelLabData* sharedData;  // Shared data source
     static bool dataLoaded;
+    static int instanceCount;         // Live sensors sharing sharedData
 
     // Energy tracking
     EnergyModel energy;
@@ -27,12 +32,39 @@ class SensorNode : public cSimpleModule
     // Configuration
     bool useRealData;
 
+    long eventsHandled;      // All messages handled (benchmarking)
+    int seqNo;               // Sequence number of the next response
+
+    // Batched responses: sense every senseInterval, send up to batchSize
+    // buffered readings per request in one SensorBatchMsg
+    int batchSize;           // 1 = one SensorMsg per request (sensed on request)
+    double senseInterval;
+    cMessage *senseTimer;
+    std::deque<SampleRecord> senseBuffer;
+    long readingsOverwritten; // Buffer full before the next request
+
+    // Compact payload encoding (payloadEncoding = "delta")
+    bool deltaEncoding;
+    PayloadCodec::State encoder;
+    int payloadRefreshInterval;     // Packets between absolute records (0 = first only)
+    long payloadBitsSent;
+    long readingsSent;
+
+  public:
+    // Called by the ClusterHead at its checkpoint (same instant for the cluster)
+    void saveCheckpoint(const std::string& dir);
+
   protected:
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
     virtual void finish() override;
 
     void loadSharedData();
+    void restoreCheckpoint(const std::string& filename);
+    SampleRecord senseReading();
+    void respondSingle(RequestMsg *req);
+    void respondBatch(RequestMsg *req);
+    void respondEncoded(RequestMsg *req, const std::vector<SampleRecord>& readings);
 };
 
 #endif
@@ -1,5 +1,7 @@
 //
 // Sink - Receives clean data from ClusterHead and collects final statistics
+// Accepts raw SensorMsg packets or aggregated SummaryMsg windows
+// Multi-cluster: merges per-CH ModelMsg reports into a network-wide model
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU Lesser General Public License as published by
@@ -8,7 +10,6 @@
 //
 
 #include "Sink.h"
-#include "messages_m.h"
 
 Define_Module(Sink);
 
@@ -16,25 +17,142 @@ void Sink::initialize()
 {
     totalReceived = 0;
     truePositives = 0;
+    eventsHandled = 0;
+    summariesReceived = 0;
+    outliersReported = 0;
+    cleanStats.reset();
+    chModels.clear();
+    reportedThisRound.clear();
+    modelReportsReceived = 0;
+    globalModelsSent = 0;
+    senseToDeliverySignal = registerSignal("senseToDelivery");
 
     // Watch variables in GUI
     WATCH(totalReceived);
+    WATCH(summariesReceived);
 }
 
 void Sink::handleMessage(cMessage *msg)
 {
-    SensorMsg *sMsg = check_and_cast<SensorMsg *>(msg);
+    eventsHandled++;
 
+    if (SummaryMsg *summary = dynamic_cast<SummaryMsg *>(msg)) {
+        handleSummaryMsg(summary);
+    } else if (ModelMsg *model = dynamic_cast<ModelMsg *>(msg)) {
+        handleModelMsg(model);
+    } else {
+        handleSensorMsg(check_and_cast<SensorMsg *>(msg));
+    }
+    delete msg;
+}
+
+void Sink::handleSensorMsg(SensorMsg *sMsg)
+{
     totalReceived++;
 
+    double x[SufficientStats::DIM] = {
+        sMsg->getTemperature(), sMsg->getHumidity(), sMsg->getLight(), sMsg->getVoltage()
+    };
+    cleanStats.add(x);
+
+    simtime_t latency = simTime() - sMsg->getSenseTime();
+    emit(senseToDeliverySignal, latency);
+    deliveryLatency.record(sMsg->getSourceId(), latency);
+
     // Log received data
-    EV << "Sink received CLEAN data from Node " << sMsg->getSourceId()
+    EV_DEBUG << "Sink received CLEAN data from Node " << sMsg->getSourceId()
        << " | T=" << sMsg->getTemperature()
        << " H=" << sMsg->getHumidity()
        << " L=" << sMsg->getLight()
        << " V=" << sMsg->getVoltage() << "\n";
+}
 
-    delete msg;
+// Reconstruct the clean-data statistics from a CH window summary
+void Sink::handleSummaryMsg(SummaryMsg *summary)
+{
+    const int D = SufficientStats::DIM;
+    double mean[D], cov[D][D], mn[D], mx[D];
+    for (int j = 0; j < D; j++) {
+        mean[j] = summary->getMean(j);
+        mn[j] = summary->getMinValue(j);
+        mx[j] = summary->getMaxValue(j);
+        for (int k = 0; k < D; k++) {
+            cov[j][k] = summary->getCovariance(j * D + k);
+        }
+    }
+
+    SufficientStats interval;
+    interval.setFromSummary(summary->getCount(), mean, cov, mn, mx);
+    cleanStats.merge(interval);
+
+    summariesReceived++;
+    totalReceived += summary->getCount();
+    outliersReported += summary->getOutlierSourcesArraySize();
+
+    EV << "Sink received SUMMARY from CH " << summary->getChId()
+       << " | n=" << summary->getCount()
+       << " T=" << mean[0] << " H=" << mean[1]
+       << " L=" << mean[2] << " V=" << mean[3]
+       << " outliers=" << summary->getOutlierSourcesArraySize() << "\n";
+}
+
+// Store the latest window model of one CH; merge them pairwise (O(d^2) per
+// CH) and send the result back once every CH has reported at least once and
+// the round is over: all CHs reported since the last broadcast, or one
+// reports again. A CH that skips reports (cold EWMA, window < 2) then delays
+// the others by at most one report interval, its latest model is merged.
+void Sink::handleModelMsg(ModelMsg *model)
+{
+    const int D = SufficientStats::DIM;
+    int chIndex = model->getArrivalGate()->getIndex();
+
+    // Rebuild the CH's statistics from (n, mean, scatter)
+    double mean[D], cov[D][D], mn[D], mx[D];
+    int n = model->getCount();
+    for (int j = 0; j < D; j++) {
+        mean[j] = model->getMean(j);
+        mn[j] = mx[j] = mean[j];  // Range is not part of a model report
+        for (int k = 0; k < D; k++) {
+            cov[j][k] = (n > 1) ? model->getScatter(j * D + k) / (n - 1) : 0.0;
+        }
+    }
+    chModels[chIndex].setFromSummary(n, mean, cov, mn, mx);
+    modelReportsReceived++;
+
+    bool repeated = !reportedThisRound.insert(chIndex).second;
+    int numCH = gateSize("toCH");
+    if (numCH > 0 && (int)chModels.size() >= numCH
+        && (repeated || (int)reportedThisRound.size() >= numCH)) {
+        broadcastGlobalModel();
+        reportedThisRound.clear();
+        if (repeated) reportedThisRound.insert(chIndex);  // Opens the next round
+    }
+}
+
+void Sink::broadcastGlobalModel()
+{
+    const int D = SufficientStats::DIM;
+    SufficientStats global;
+    for (const auto& pair : chModels) {
+        global.merge(pair.second);
+    }
+
+    for (int i = 0; i < gateSize("toCH"); i++) {
+        ModelMsg *msg = new ModelMsg("GlobalModel");
+        msg->setChId(-1);
+        msg->setCount(global.getCount());
+        for (int j = 0; j < D; j++) {
+            msg->setMean(j, global.getMean(j));
+            for (int k = 0; k < D; k++) {
+                msg->setScatter(j * D + k, global.getScatter(j, k));
+            }
+        }
+        send(msg, "toCH", i);
+    }
+    globalModelsSent++;
+
+    EV << "Sink merged " << chModels.size() << " CH models -> global n="
+       << global.getCount() << " T=" << global.getMean(0) << "\n";
 }
 
 void Sink::finish()
@@ -43,5 +161,29 @@ void Sink::finish()
     EV << "           SINK SUMMARY\n";
     EV << "========================================\n";
     EV << "Total Clean Packets Received: " << totalReceived << "\n";
+    EV << "Summaries Received:           " << summariesReceived << "\n";
+    EV << "Outliers Reported:            " << outliersReported << "\n";
+    EV << "Sink Events Handled:          " << eventsHandled << "\n";
+    if (modelReportsReceived > 0) {
+        EV << "CH Model Reports:             " << modelReportsReceived
+           << " (" << chModels.size() << " CHs, " << globalModelsSent << " global models sent)\n";
+    }
+    if (cleanStats.getCount() > 1) {
+        EV << "----------------------------------------\n";
+        EV << "Clean Data Mean: T=" << cleanStats.getMean(0)
+           << " H=" << cleanStats.getMean(1)
+           << " L=" << cleanStats.getMean(2)
+           << " V=" << cleanStats.getMean(3) << "\n";
+        EV << "Clean Data Var:  T=" << cleanStats.getCovariance(0, 0)
+           << " H=" << cleanStats.getCovariance(1, 1)
+           << " L=" << cleanStats.getCovariance(2, 2)
+           << " V=" << cleanStats.getCovariance(3, 3) << "\n";
+        EV << "Range T: [" << cleanStats.getMin(0) << ", " << cleanStats.getMax(0) << "]\n";
+    }
     EV << "========================================\n";
+
+    recordScalar("eventsHandled", eventsHandled);
+    recordScalar("cleanSamplesReceived", totalReceived);
+    recordScalar("summariesReceived", summariesReceived);
+    deliveryLatency.recordScalars(this);
 }
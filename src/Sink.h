@@ -17,6 +17,11 @@
 #define __ODAMD_WSNS_SINK_H_
 
 #include <omnetpp.h>
+#include <map>
+#include <set>
+#include "SufficientStats.h"
+#include "LatencyStats.h"
+#include "messages_m.h"
 
 using namespace omnetpp;
 
@@ -25,11 +30,35 @@ class Sink : public cSimpleModule
   private:
     long totalReceived;
     long truePositives; // Số Outlier phát hiện đúng (nếu CH gửi thông báo detection)
+    long eventsHandled;         // Messages processed by the Sink (raw packets + summaries)
+    long summariesReceived;
+    long outliersReported;      // Outliers listed in received summaries
+
+    // Network-wide statistics of clean data, rebuilt from raw packets or summaries
+    SufficientStats cleanStats;
+
+    // Multi-cluster: latest local model per CH (by arrival gate), merged into a global model
+    std::map<int, SufficientStats> chModels;
+    std::set<int> reportedThisRound;    // Since the last broadcast
+    long modelReportsReceived;
+    long globalModelsSent;
+
+    // Sense -> delivery latency of raw packets, per source
+    LatencyStats deliveryLatency;
+    simsignal_t senseToDeliverySignal;
+
+  public:
+    Sink() : deliveryLatency("senseToDelivery") {}
 
   protected:
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
     virtual void finish() override;
+
+    void handleSensorMsg(SensorMsg *sMsg);
+    void handleSummaryMsg(SummaryMsg *summary);
+    void handleModelMsg(ModelMsg *model);
+    void broadcastGlobalModel();
 };
 
 #endif
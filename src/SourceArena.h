@@ -0,0 +1,122 @@
+//
+// Per-source sample windows in one contiguous arena
+// Each source (mote ID) gets a dense slot on first use; slot s owns the
+// block [s * windowSize * 4, (s + 1) * windowSize * 4) of a single double
+// array, used as a ring of its last windowSize readings (T, H, L, V).
+// Source -> slot is a direct-indexed table, so lookups are O(1) and no
+// per-source heap object is ever allocated; adding a source only grows the
+// arrays (amortised).
+//
+// Other per-source state (e.g. EwmaModel) uses the same slot numbers as
+// the index into its own array.
+//
+
+#ifndef __ODAMD_SOURCEARENA_H_
+#define __ODAMD_SOURCEARENA_H_
+
+#include <cstdint>
+#include <vector>
+#include "DetectorMath.h"
+#include "Checkpoint.h"
+
+class SourceArena {
+  public:
+    static const int DIM = 4;
+
+  private:
+    struct Ring {
+        int32_t next;           // Row of the next reading
+        int32_t count;          // Readings held (<= windowSize)
+    };
+
+    int windowSize;
+    std::vector<int32_t> slotBySource;  // -1 = no slot yet
+    std::vector<int32_t> sourceBySlot;
+    std::vector<Ring> rings;
+    std::vector<double> samples;        // numSlots x windowSize x DIM
+
+  public:
+    SourceArena() : windowSize(0) {}
+
+    void configure(int window) {
+        windowSize = window;
+        slotBySource.clear();
+        sourceBySlot.clear();
+        rings.clear();
+        samples.clear();
+    }
+
+    // Dense slot of a source, allocated on first use (sourceId >= 0)
+    int slotFor(int sourceId) {
+        if (sourceId >= (int)slotBySource.size()) slotBySource.resize(sourceId + 1, -1);
+        int32_t& slot = slotBySource[sourceId];
+        if (slot < 0) {
+            slot = sourceBySlot.size();
+            sourceBySlot.push_back(sourceId);
+            rings.push_back(Ring{0, 0});
+            samples.resize(samples.size() + (size_t)windowSize * DIM, 0.0);
+        }
+        return slot;
+    }
+
+    int getNumSlots() const { return sourceBySlot.size(); }
+    int getSource(int slot) const { return sourceBySlot[slot]; }
+    int getCount(int slot) const { return rings[slot].count; }
+
+    // Append a reading to the slot's window, replacing the oldest when full
+    void push(int slot, const std::vector<double>& x) {
+        Ring& r = rings[slot];
+        double *row = &samples[((size_t)slot * windowSize + r.next) * DIM];
+        for (int j = 0; j < DIM; j++) row[j] = x[j];
+        if (++r.next == windowSize) r.next = 0;
+        if (r.count < windowSize) r.count++;
+    }
+
+    // The slot's window, oldest reading first, into X (resized to count rows)
+    void window(int slot, DetectorMath::Matrix& X) const {
+        const Ring& r = rings[slot];
+        X.resize(r.count, std::vector<double>(DIM));
+        int first = (r.count < windowSize) ? 0 : r.next;
+        const double *block = &samples[(size_t)slot * windowSize * DIM];
+        for (int i = 0; i < r.count; i++) {
+            const double *row = block + (size_t)((first + i) % windowSize) * DIM;
+            for (int j = 0; j < DIM; j++) X[i][j] = row[j];
+        }
+    }
+
+    void save(CheckpointWriter& out) const {
+        out.put((int32_t)windowSize);
+        out.putVector(slotBySource);
+        out.putVector(sourceBySlot);
+        out.putVector(rings);
+        out.putVector(samples);
+    }
+
+    // False (arena unchanged) if saved with another window size
+    bool load(CheckpointReader& in) {
+        int32_t window = 0;
+        std::vector<int32_t> bySource, bySlot;
+        std::vector<Ring> r;
+        std::vector<double> s;
+        in.get(window);
+        in.getVector(bySource);
+        in.getVector(bySlot);
+        in.getVector(r);
+        in.getVector(s);
+        if (!in.good() || window != windowSize || r.size() != bySlot.size()
+                || s.size() != r.size() * (size_t)windowSize * DIM) return false;
+        slotBySource.swap(bySource);
+        sourceBySlot.swap(bySlot);
+        rings.swap(r);
+        samples.swap(s);
+        return true;
+    }
+
+    // Memory held by the arena (excluding the source -> slot table)
+    size_t getBytes() const {
+        return samples.capacity() * sizeof(double) + rings.capacity() * sizeof(Ring)
+               + sourceBySlot.capacity() * sizeof(int32_t);
+    }
+};
+
+#endif
@@ -0,0 +1,104 @@
+//
+// Per-stage hot-path timers for the ClusterHead detectors
+// Compiled in only with -DODAMD_PROFILING (make PROFILING=1, see makefrag);
+// otherwise PROFILE_STAGE expands to nothing and costs nothing.
+//
+// Each stage collects its wall-clock duration (microseconds) into a
+// cHistogram; recordScalars() writes the histograms plus p50/p95/p99
+// into the .sca file.
+//
+
+#ifndef __ODAMD_STAGETIMER_H_
+#define __ODAMD_STAGETIMER_H_
+
+#include <omnetpp.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace omnetpp;
+
+class StageProfiler {
+  private:
+    std::vector<std::string> names;
+    std::vector<cHistogram *> histograms;
+
+  public:
+    StageProfiler() {}
+    ~StageProfiler() {
+        for (auto h : histograms) delete h;
+    }
+
+    // Register a stage; returns its index for record()
+    int addStage(const std::string& name) {
+        names.push_back(name);
+        histograms.push_back(new cHistogram(name.c_str()));
+        return names.size() - 1;
+    }
+
+    void record(int stage, double microseconds) {
+        histograms[stage]->collect(microseconds);
+    }
+
+    // Quantile estimate from histogram bins (linear within a bin)
+    static double quantile(const cHistogram *h, double q) {
+        double total = h->getSumWeights();
+        if (total <= 0) return 0.0;
+        double target = q * total;
+        double cumulative = h->getUnderflowSumWeights();
+        if (cumulative >= target) return h->getMin();
+        for (int i = 0; i < h->getNumBins(); i++) {
+            double w = h->getBinValue(i);
+            if (cumulative + w >= target && w > 0) {
+                double lo = h->getBinEdge(i), hi = h->getBinEdge(i + 1);
+                return lo + (hi - lo) * (target - cumulative) / w;
+            }
+            cumulative += w;
+        }
+        return h->getMax();
+    }
+
+    // Histograms and percentiles -> .sca (called from finish())
+    void recordScalars(cComponent *owner) {
+        for (size_t i = 0; i < names.size(); i++) {
+            cHistogram *h = histograms[i];
+            if (h->getCount() == 0) continue;
+            std::string prefix = "cpu:" + names[i];
+            owner->recordStatistic(prefix.c_str(), h, "us");
+            owner->recordScalar((prefix + ":p50").c_str(), quantile(h, 0.50), "us");
+            owner->recordScalar((prefix + ":p95").c_str(), quantile(h, 0.95), "us");
+            owner->recordScalar((prefix + ":p99").c_str(), quantile(h, 0.99), "us");
+        }
+    }
+};
+
+#ifdef ODAMD_PROFILING
+
+// Measures the enclosing scope with steady_clock and records it on exit
+class ScopedStageTimer {
+  private:
+    StageProfiler& profiler;
+    int stage;
+    std::chrono::steady_clock::time_point start;
+
+  public:
+    ScopedStageTimer(StageProfiler& p, int s)
+        : profiler(p), stage(s), start(std::chrono::steady_clock::now()) {}
+    ~ScopedStageTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        profiler.record(stage, std::chrono::duration<double, std::micro>(elapsed).count());
+    }
+};
+
+#define ODAMD_CONCAT_(a, b) a##b
+#define ODAMD_CONCAT(a, b) ODAMD_CONCAT_(a, b)
+#define PROFILE_STAGE(profiler, stage) \
+    ScopedStageTimer ODAMD_CONCAT(stageTimer_, __LINE__)(profiler, stage)
+
+#else
+
+#define PROFILE_STAGE(profiler, stage) ((void)0)
+
+#endif
+
+#endif
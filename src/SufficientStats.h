@@ -0,0 +1,106 @@
+//
+// Sufficient statistics for 4D sensor samples (T, H, L, V)
+// Keeps count, mean, scatter matrix and per-feature min/max so that
+// summaries from different intervals (or clusters) can be merged exactly
+//
+
+#ifndef __ODAMD_SUFFICIENTSTATS_H_
+#define __ODAMD_SUFFICIENTSTATS_H_
+
+#include <algorithm>
+#include <limits>
+
+class SufficientStats {
+  public:
+    static const int DIM = 4;
+
+  private:
+    long count;
+    double mean[DIM];
+    double scatter[DIM][DIM];   // Sum of (x - mean)(x - mean)^T
+    double minValue[DIM];
+    double maxValue[DIM];
+
+  public:
+    SufficientStats() {
+        reset();
+    }
+
+    void reset() {
+        count = 0;
+        for (int j = 0; j < DIM; j++) {
+            mean[j] = 0.0;
+            minValue[j] = std::numeric_limits<double>::infinity();
+            maxValue[j] = -std::numeric_limits<double>::infinity();
+            for (int k = 0; k < DIM; k++) scatter[j][k] = 0.0;
+        }
+    }
+
+    // Add one sample (Welford update, numerically stable)
+    void add(const double x[DIM]) {
+        count++;
+        double delta[DIM];
+        for (int j = 0; j < DIM; j++) {
+            delta[j] = x[j] - mean[j];
+            mean[j] += delta[j] / count;
+        }
+        for (int j = 0; j < DIM; j++) {
+            for (int k = 0; k < DIM; k++) {
+                scatter[j][k] += delta[j] * (x[k] - mean[k]);
+            }
+            minValue[j] = std::min(minValue[j], x[j]);
+            maxValue[j] = std::max(maxValue[j], x[j]);
+        }
+    }
+
+    // Merge another set of statistics (Chan et al. pairwise update, O(d^2))
+    void merge(const SufficientStats& other) {
+        if (other.count == 0) return;
+        if (count == 0) {
+            *this = other;
+            return;
+        }
+        double n = count + other.count;
+        double delta[DIM];
+        for (int j = 0; j < DIM; j++) delta[j] = other.mean[j] - mean[j];
+        double w = (double)count * other.count / n;
+        for (int j = 0; j < DIM; j++) {
+            for (int k = 0; k < DIM; k++) {
+                scatter[j][k] += other.scatter[j][k] + delta[j] * delta[k] * w;
+            }
+        }
+        for (int j = 0; j < DIM; j++) {
+            mean[j] += delta[j] * other.count / n;
+            minValue[j] = std::min(minValue[j], other.minValue[j]);
+            maxValue[j] = std::max(maxValue[j], other.maxValue[j]);
+        }
+        count += other.count;
+    }
+
+    // Rebuild statistics from a transmitted summary (covariance is unbiased, n-1)
+    void setFromSummary(long n, const double m[DIM], const double cov[DIM][DIM],
+                        const double mn[DIM], const double mx[DIM]) {
+        count = n;
+        for (int j = 0; j < DIM; j++) {
+            mean[j] = m[j];
+            minValue[j] = mn[j];
+            maxValue[j] = mx[j];
+            for (int k = 0; k < DIM; k++) {
+                scatter[j][k] = (n > 1) ? cov[j][k] * (n - 1) : 0.0;
+            }
+        }
+    }
+
+    long getCount() const { return count; }
+    double getMean(int j) const { return mean[j]; }
+    double getScatter(int j, int k) const { return scatter[j][k]; }
+    double getMin(int j) const { return minValue[j]; }
+    double getMax(int j) const { return maxValue[j]; }
+
+    // Unbiased sample covariance
+    double getCovariance(int j, int k) const {
+        return (count > 1) ? scatter[j][k] / (count - 1) : 0.0;
+    }
+};
+
+#endif
@@ -0,0 +1,82 @@
+//
+// TraceReplaySource - Feeds a recorded arrival trace into a ClusterHead
+// Each record becomes a SensorMsg sent on "out" (zero-delay link to the
+// CH's in[] gate), either at its recorded arrival time, so the CH sees the
+// same arrival sequence and timing as in the recording, or back to back
+// (replaySpacing apart) for fast tuning loops. In the fast mode senseTime
+// keeps the recorded sense -> arrival gap.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "TraceReplaySource.h"
+
+Define_Module(TraceReplaySource);
+
+TraceReplaySource::~TraceReplaySource()
+{
+    cancelAndDelete(replayTimer);
+}
+
+void TraceReplaySource::initialize()
+{
+    std::string traceFile = par("traceFile").stdstringValue();
+    if (!reader.open(traceFile))
+        throw cRuntimeError("Cannot open arrival trace '%s' (recorded with ClusterHead.recordArrivals)", traceFile.c_str());
+    if (reader.getScaleExp() != SimTime::getScaleExp())
+        throw cRuntimeError("Arrival trace '%s' was recorded with simtime-resolution 10^%d s, this run uses 10^%d s",
+                            traceFile.c_str(), reader.getScaleExp(), SimTime::getScaleExp());
+
+    std::string timing = par("timing").stdstringValue();
+    if (timing == "recorded") recordedTiming = true;
+    else if (timing == "fast") recordedTiming = false;
+    else throw cRuntimeError("Unknown timing '%s' (recorded, fast)", timing.c_str());
+    replaySpacing = par("replaySpacing").doubleValue();
+    recordsReplayed = 0;
+
+    replayTimer = new cMessage("replayTimer");
+    hasPending = reader.next(pending);
+    scheduleNext();
+}
+
+void TraceReplaySource::scheduleNext()
+{
+    if (!hasPending) {
+        reader.close();
+        return;
+    }
+    simtime_t at = recordedTiming ? SimTime::fromRaw(pending.arrivalTime) : simTime();
+    if (!recordedTiming && recordsReplayed > 0) at += replaySpacing;
+    if (at < simTime()) at = simTime();
+    scheduleAt(at, replayTimer);
+}
+
+void TraceReplaySource::handleMessage(cMessage *msg)
+{
+    ASSERT(msg == replayTimer);
+
+    SensorMsg *s = new SensorMsg("SensorData");
+    s->setSourceId(pending.sourceId);
+    s->setTemperature(pending.temperature);
+    s->setHumidity(pending.humidity);
+    s->setLight(pending.light);
+    s->setVoltage(pending.voltage);
+    s->setIsOutlier(pending.isOutlier != 0);
+    s->setSenseTime(recordedTiming ? SimTime::fromRaw(pending.senseTime)
+                                   : simTime() - SimTime::fromRaw(pending.arrivalTime - pending.senseTime));
+    s->setRequestId(pending.requestId);
+    s->setSeqNo(pending.seqNo);
+    send(s, "out");
+    recordsReplayed++;
+
+    hasPending = reader.next(pending);
+    scheduleNext();
+}
+
+void TraceReplaySource::finish()
+{
+    recordScalar("recordsReplayed", recordsReplayed);
+}
@@ -0,0 +1,38 @@
+//
+// TraceReplaySource - Feeds a recorded arrival trace (ArrivalTrace.h) into a ClusterHead
+// Stands in for the SensorNodes: no data loading, no RequestMsg traffic
+//
+
+#ifndef __ODAMD_TRACEREPLAYSOURCE_H_
+#define __ODAMD_TRACEREPLAYSOURCE_H_
+
+#include <omnetpp.h>
+#include "messages_m.h"
+#include "ArrivalTrace.h"
+
+using namespace omnetpp;
+
+class TraceReplaySource : public cSimpleModule
+{
+  private:
+    ArrivalTraceReader reader;
+    ArrivalRecord pending;          // Next record to send
+    bool hasPending;
+    bool recordedTiming;            // false: as fast as possible
+    double replaySpacing;           // Gap between samples when not at recorded timing
+    cMessage *replayTimer;
+    long recordsReplayed;
+
+  public:
+    TraceReplaySource() : replayTimer(nullptr) {}
+    virtual ~TraceReplaySource();
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    void scheduleNext();
+};
+
+#endif
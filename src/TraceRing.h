@@ -0,0 +1,89 @@
+//
+// Binary trace ring for per-sample detection decisions
+// Fixed-size ring of POD records (time, source, MD, decision, truth):
+// recording is a struct copy, no formatting. The ring is dumped to a
+// binary file for post-mortem analysis and decoded offline
+// (simulations/decode_trace.py).
+//
+// File layout (native little-endian):
+//   char[4]  magic "ODTR"
+//   uint32   version (1)
+//   uint32   record size in bytes
+//   uint32   reserved
+//   uint64   total records pushed (including overwritten ones)
+//   uint64   records in file (oldest first)
+//   records...
+//
+
+#ifndef __ODAMD_TRACERING_H_
+#define __ODAMD_TRACERING_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct TraceRecord {
+    double time;            // Simulation time of the decision (s)
+    int32_t sourceId;       // Mote ID of the sample
+    float score;            // Detector score (MD, or OD cluster flag)
+    uint8_t blocked;        // Decision: 1 = outlier (blocked), 0 = forwarded
+    uint8_t truth;          // Ground truth: 1 = injected outlier
+    uint16_t reserved;
+};
+
+class TraceRing {
+  private:
+    std::vector<TraceRecord> records;
+    size_t next;            // Slot of the next record
+    uint64_t total;         // Records pushed since reset
+
+  public:
+    TraceRing() : next(0), total(0) {}
+
+    // capacity 0 disables tracing
+    void setCapacity(size_t capacity) {
+        records.assign(capacity, TraceRecord());
+        next = 0;
+        total = 0;
+    }
+
+    bool isEnabled() const { return !records.empty(); }
+    uint64_t getTotal() const { return total; }
+    uint64_t getCount() const { return (total < records.size()) ? total : records.size(); }
+
+    void push(double time, int sourceId, double score, bool blocked, bool truth) {
+        if (records.empty()) return;
+        TraceRecord& r = records[next];
+        r.time = time;
+        r.sourceId = sourceId;
+        r.score = (float)score;
+        r.blocked = blocked;
+        r.truth = truth;
+        r.reserved = 0;
+        if (++next == records.size()) next = 0;
+        total++;
+    }
+
+    // Write the ring (oldest record first); returns false on I/O error
+    bool dump(const std::string& filename) const {
+        FILE *f = fopen(filename.c_str(), "wb");
+        if (f == nullptr) return false;
+
+        uint64_t count = getCount();
+        uint32_t header[4] = {0, 1, (uint32_t)sizeof(TraceRecord), 0};
+        memcpy(&header[0], "ODTR", 4);
+        fwrite(header, sizeof(header), 1, f);
+        fwrite(&total, sizeof(total), 1, f);
+        fwrite(&count, sizeof(count), 1, f);
+
+        size_t start = (total < records.size()) ? 0 : next;
+        for (uint64_t i = 0; i < count; i++) {
+            fwrite(&records[(start + i) % records.size()], sizeof(TraceRecord), 1, f);
+        }
+        return fclose(f) == 0;
+    }
+};
+
+#endif